@@ -0,0 +1,351 @@
+/*
+	broadcastbuffer.cpp - Implementation of the BroadcastBuffer class.
+	
+	Revision 0.
+	
+	Notes:
+			-
+	
+	2026/10/17
+*/
+
+
+//#define DEBUG 1
+
+#include "broadcastbuffer.h"
+
+#include <cstring>
+#ifdef DEBUG
+#include <iostream>
+#endif
+
+
+// Head value of a reader that was detached by the writer.
+const uint64_t BB_DETACHED = UINT64_MAX;
+
+
+// --- CONSTRUCTOR ---
+BroadcastBuffer::BroadcastBuffer() {
+	buffer = 0;
+	end = 0;
+	capacity = 0;
+	cursors = 0;
+	maxReaders = 0;
+	tail = 0;
+	lowCache = 0;
+	back = 0;
+	lagPolicy = BB_LAG_BLOCK;
+	maxLag = 0;
+}
+
+
+// --- DESTRUCTOR ---
+BroadcastBuffer::~BroadcastBuffer() {
+	cleanup();
+}
+
+
+// --- INIT ---
+// Initialises a new buffer of 'capacity' bytes, with room for 'maxReaders' readers.
+// Returns false on error, otherwise true.
+bool BroadcastBuffer::init(uint32_t capacity, uint32_t maxReaders) {
+	if (capacity == 0 || maxReaders == 0) { return false; }
+	
+	cleanup();
+	buffer = new uint8_t[capacity];
+	end = buffer + capacity;
+	back = buffer;
+	this->capacity = capacity;
+	
+	cursors = new Cursor[maxReaders];
+	this->maxReaders = maxReaders;
+	for (uint32_t i = 0; i < maxReaders; ++i) {
+		cursors[i].head = BB_DETACHED;
+		cursors[i].dropped = 0;
+		cursors[i].attached = false;
+		cursors[i].tailCache = 0;
+		cursors[i].peekHead = 0;
+	}
+	
+	tail = 0;
+	lowCache = 0;
+	
+	return true;
+}
+
+
+// --- CLEAN UP ---
+// Delete the buffer and the reader cursors.
+bool BroadcastBuffer::cleanup() {
+	if (buffer != 0) {
+		delete[] buffer;
+		buffer = 0;
+	}
+	
+	if (cursors != 0) {
+		delete[] cursors;
+		cursors = 0;
+	}
+	
+	maxReaders = 0;
+	
+	return true;
+}
+
+
+// --- SET LAG POLICY ---
+// Set what happens to readers that hold up the writer. Readers with up to 'maxLag' unread
+// bytes always hold up the writer, the policy applies to readers lagging further behind.
+void BroadcastBuffer::setLagPolicy(BroadcastLagPolicy policy, uint32_t maxLag) {
+	std::lock_guard<std::mutex> lk(readerMutex);
+	lagPolicy = policy;
+	this->maxLag = maxLag;
+}
+
+
+// --- ATTACH ---
+// Add a reader. It starts reading at the data written after this call.
+// Returns the reader's index, or -1 if all readers are in use.
+int BroadcastBuffer::attach() {
+	std::lock_guard<std::mutex> lk(readerMutex);
+	for (uint32_t i = 0; i < maxReaders; ++i) {
+		Cursor &cursor = cursors[i];
+		if (cursor.attached) { continue; }
+	
+		uint64_t loctail = tail.load(std::memory_order_acquire);
+		cursor.tailCache = loctail;
+		cursor.peekHead = loctail;
+		cursor.dropped = 0;
+		cursor.head.store(loctail, std::memory_order_relaxed);
+		cursor.attached.store(true, std::memory_order_release);
+	
+		return i;
+	}
+	
+	return -1;
+}
+
+
+// --- DETACH ---
+// Remove a reader. Its space is freed for the writer.
+void BroadcastBuffer::detach(uint32_t reader) {
+	if (reader >= maxReaders) { return; }
+	
+	std::lock_guard<std::mutex> lk(readerMutex);
+	cursors[reader].head.store(BB_DETACHED, std::memory_order_release);
+	cursors[reader].attached = false;
+}
+
+
+// --- IS ATTACHED ---
+// Returns false if the reader detached itself or was detached by the lag policy.
+bool BroadcastBuffer::isAttached(uint32_t reader) {
+	if (reader >= maxReaders) { return false; }
+	
+	return cursors[reader].attached &&
+				cursors[reader].head.load(std::memory_order_acquire) != BB_DETACHED;
+}
+
+
+// --- DROPPED ---
+// Returns the number of bytes the reader lost to the lag policy.
+uint64_t BroadcastBuffer::dropped(uint32_t reader) {
+	if (reader >= maxReaders) { return 0; }
+	
+	return cursors[reader].dropped;
+}
+
+
+// --- PEEK ---
+// Obtain the reader's unread section of the buffer without copying it, like
+// StreamBuffer::peek(). If the lag policy drops data for the reader, the spans may be
+// overwritten before commit(), which then fails.
+// Returns the total number of unread bytes in both spans.
+uint32_t BroadcastBuffer::peek(uint32_t reader, BufferSpan &first, BufferSpan &second) {
+	first.data = buffer;
+	first.length = 0;
+	second.data = buffer;
+	second.length = 0;
+	if (reader >= maxReaders) { return 0; }
+	
+	// Remember the head the spans start at. If the writer moves it before commit(), the spans
+	// were overwritten.
+	Cursor &cursor = cursors[reader];
+	uint64_t lochead = cursor.head.load(std::memory_order_acquire);
+	if (lochead == BB_DETACHED) { return 0; }
+	
+	cursor.tailCache = tail.load(std::memory_order_acquire);
+	cursor.peekHead = lochead;
+	uint32_t locunread = cursor.tailCache - lochead;
+	if (locunread == 0) { return 0; }
+	
+	uint8_t* index = buffer + (lochead % capacity);
+	uint32_t bytesSingleRead = locunread;
+	if ((uint32_t) (end - index) < bytesSingleRead) { bytesSingleRead = end - index; }
+	
+	first.data = index;
+	first.length = bytesSingleRead;
+	second.length = locunread - bytesSingleRead;
+	
+	return locunread;
+}
+
+
+// --- ADVANCE ---
+// Move the reader's head from 'from' past 'len' bytes. Fails if the writer moved or detached
+// the reader in the meantime.
+bool BroadcastBuffer::advance(uint32_t reader, uint64_t from, uint32_t len) {
+	// The release ordering ensures that we are done reading the bytes before the writer sees
+	// them as free. The writer claims a lagging reader's head the same way, so only one of us
+	// succeeds.
+	return cursors[reader].head.compare_exchange_strong(from, from + len,
+											std::memory_order_acq_rel, std::memory_order_acquire);
+}
+
+
+// --- COMMIT ---
+// Mark 'len' bytes obtained with peek() as read.
+// Returns the number of bytes committed, or 0 if the data was dropped or the reader detached
+// while it was being read. In that case the data obtained with peek() must be discarded.
+uint32_t BroadcastBuffer::commit(uint32_t reader, uint32_t len) {
+	if (reader >= maxReaders) { return 0; }
+	
+	// Commit from the head seen by peek(), so that a drop in between is noticed. Only the bytes
+	// peek() returned can be committed.
+	Cursor &cursor = cursors[reader];
+	uint32_t locunread = cursor.tailCache - cursor.peekHead;
+	if (len > locunread) { len = locunread; }
+	
+	if (!advance(reader, cursor.peekHead, len)) { return 0; }
+	
+	return len;
+}
+
+
+// --- READ ---
+// Attempts to read 'len' bytes for the reader into the provided buffer. Data the lag policy
+// dropped while it was being copied is skipped.
+// Returns the number of bytes read.
+uint32_t BroadcastBuffer::read(uint32_t reader, uint32_t len, uint8_t* bytes) {
+	if (reader >= maxReaders) { return 0; }
+	
+	for (;;) {
+		BufferSpan first, second;
+		uint32_t locunread = peek(reader, first, second);
+		if (locunread == 0) { return 0; }
+		if (len > locunread) { len = locunread; }
+	
+		uint32_t bytesToRead = (first.length < len) ? first.length : len;
+		memcpy(bytes, first.data, bytesToRead);
+		if (len > bytesToRead) {
+			memcpy(bytes + bytesToRead, second.data, len - bytesToRead);
+		}
+	
+		if (advance(reader, cursors[reader].peekHead, len)) { return len; }
+
+#ifdef DEBUG
+		std::cout << "BroadcastBuffer::read: data dropped while reading, retrying." << std::endl;
+#endif
+	}
+}
+
+
+// --- WRITABLE ---
+// Find the slowest reader, applying the lag policy to readers that hold up a write of 'want'
+// bytes.
+// Returns the number of free bytes.
+uint32_t BroadcastBuffer::writable(uint32_t want) {
+	std::lock_guard<std::mutex> lk(readerMutex);
+	uint64_t loctail = tail.load(std::memory_order_relaxed);
+	if (want > capacity) { want = capacity; }
+	uint64_t need = (loctail + want > capacity) ? loctail + want - capacity : 0;
+	
+	uint64_t floor = loctail;
+	for (uint32_t i = 0; i < maxReaders; ++i) {
+		Cursor &cursor = cursors[i];
+		if (!cursor.attached) { continue; }
+	
+		uint64_t lochead = cursor.head.load(std::memory_order_acquire);
+		while (lochead != BB_DETACHED && lochead < need && lagPolicy != BB_LAG_BLOCK &&
+															loctail - lochead > maxLag) {
+			// Take the reader's data away. If the reader moves its head first, try again.
+			uint64_t target = (lagPolicy == BB_LAG_DROP) ? need : BB_DETACHED;
+			if (cursor.head.compare_exchange_weak(lochead, target, std::memory_order_acq_rel,
+															std::memory_order_acquire)) {
+#ifdef DEBUG
+				std::cout << "Reader " << i << " lagging, "
+							<< ((target == BB_DETACHED) ? "detached." : "dropping data.") << std::endl;
+#endif
+				if (target != BB_DETACHED) { cursor.dropped += target - lochead; }
+				lochead = target;
+			}
+		}
+	
+		if (lochead == BB_DETACHED) {
+			cursor.attached = false;
+			continue;
+		}
+	
+		if (lochead < floor) { floor = lochead; }
+	}
+	
+	lowCache = floor;
+	return capacity - (loctail - floor);
+}
+
+
+// --- RESERVE ---
+// Obtain up to 'max' bytes of free space to write into directly, like StreamBuffer::reserve().
+// Returns the total number of bytes in both spans.
+uint32_t BroadcastBuffer::reserve(uint32_t max, BufferSpan &first, BufferSpan &second) {
+	// Use the cached slowest reader if it shows enough free space, otherwise refresh it.
+	uint32_t locfree = capacity - (tail.load(std::memory_order_relaxed) - lowCache);
+	if (locfree < max) { locfree = writable(max); }
+	if (max < locfree) { locfree = max; }
+	uint32_t bytesSingleWrite = locfree;
+	if ((uint32_t) (end - back) < bytesSingleWrite) { bytesSingleWrite = end - back; }
+	
+	first.data = back;
+	first.length = bytesSingleWrite;
+	second.data = buffer;
+	second.length = locfree - bytesSingleWrite;
+	
+	return locfree;
+}
+
+
+// --- COMMIT WRITE ---
+// Publish 'length' bytes written into the spans obtained with reserve() to all readers.
+// Returns the number of bytes committed, which is limited to the number of free bytes.
+uint32_t BroadcastBuffer::commitWrite(uint32_t length) {
+	uint64_t loctail = tail.load(std::memory_order_relaxed);
+	uint32_t locfree = capacity - (loctail - lowCache);
+	if (length > locfree) { length = locfree; }
+	
+	back += length;
+	if (back >= end) {
+		back -= capacity;
+	}
+	
+	tail.store(loctail + length, std::memory_order_release);
+	
+	return length;
+}
+
+
+// --- WRITE ---
+// Write 'length' bytes, once for all readers.
+// Returns the number of bytes written.
+uint32_t BroadcastBuffer::write(const char* data, uint32_t length) {
+	BufferSpan first, second;
+	reserve(length, first, second);
+	
+	uint32_t bytesWritten = first.length;
+	memcpy(first.data, data, bytesWritten);
+	if (second.length > 0) {
+		memcpy(second.data, data + bytesWritten, second.length);
+		bytesWritten += second.length;
+	}
+	
+	return commitWrite(bytesWritten);
+}
@@ -0,0 +1,94 @@
+/*
+	broadcastbuffer.h - Broadcast Buffer header.
+	
+	Revision 0
+	
+	Features:
+			- Single producer, multiple consumer ring buffer. Data is written once and read by
+				every attached reader, each with its own read cursor.
+			- Free space follows the slowest attached reader.
+			- Lag policy for readers that fall too far behind: hold up the writer, drop data
+				for the reader, or detach it.
+	
+	Notes:
+			- Reader cursors are claimed with compare-and-swap, so that the writer can move or
+				detach them. A read that loses to the writer is discarded.
+	
+	2026/10/17
+*/
+
+
+#ifndef BROADCASTBUFFER_H
+#define BROADCASTBUFFER_H
+
+
+#include "streambuffer.h"
+
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+
+
+enum BroadcastLagPolicy {
+	BB_LAG_BLOCK = 0,	// The writer only gets the space all readers are done with.
+	BB_LAG_DROP,		// Readers in the way of the writer skip ahead, losing data.
+	BB_LAG_DETACH		// Readers in the way of the writer are detached.
+};
+
+
+class BroadcastBuffer {
+	// Read cursor of one reader. Padding keeps it off the cache lines of other readers.
+	struct Cursor {
+		uint8_t pad[SB_CACHE_LINE_SIZE];
+		std::atomic<uint64_t> head;		// Read position. Moved forward by the writer on a drop.
+		std::atomic<uint64_t> dropped;	// Number of bytes dropped for this reader.
+		std::atomic<bool> attached;
+		uint64_t tailCache;				// Reader's copy of 'tail'.
+		uint64_t peekHead;				// Head the spans of the last peek() start at.
+	};
+	
+	// Read-only after init(), shared by reader and writer.
+	uint8_t* buffer;		// Pointer to buffer.
+	uint8_t* end;			// Pointer to buffer end (idx Nsize).
+	uint32_t capacity;		// Total capacity of buffer in bytes.
+	Cursor* cursors;
+	uint32_t maxReaders;
+	
+	// Writer-owned state.
+	uint8_t writerPad[SB_CACHE_LINE_SIZE];
+	std::atomic<uint64_t> tail;	// Total bytes written. Only written by the writer.
+	uint64_t lowCache;		// Writer's copy of the slowest reader's head.
+	uint8_t* back;			// Pointer to back of data in buffer (last byte + 1).
+	
+	// Shared state.
+	uint8_t sharedPad[SB_CACHE_LINE_SIZE];
+	std::mutex readerMutex;		// Protects attaching and the writer's scan of the readers.
+	BroadcastLagPolicy lagPolicy;
+	uint32_t maxLag;			// Unread bytes a reader may have before the policy applies.
+	
+	uint32_t writable(uint32_t want);
+	bool advance(uint32_t reader, uint64_t from, uint32_t len);
+
+public:
+	BroadcastBuffer();
+	~BroadcastBuffer();
+	
+	BroadcastBuffer(const BroadcastBuffer&) = delete;
+	BroadcastBuffer& operator=(const BroadcastBuffer&) = delete;
+	
+	bool init(uint32_t capacity, uint32_t maxReaders);
+	bool cleanup();
+	void setLagPolicy(BroadcastLagPolicy policy, uint32_t maxLag);
+	int attach();
+	void detach(uint32_t reader);
+	bool isAttached(uint32_t reader);
+	uint64_t dropped(uint32_t reader);
+	uint32_t read(uint32_t reader, uint32_t len, uint8_t* bytes);
+	uint32_t peek(uint32_t reader, BufferSpan &first, BufferSpan &second);
+	uint32_t commit(uint32_t reader, uint32_t len);
+	uint32_t write(const char* data, uint32_t length);
+	uint32_t reserve(uint32_t max, BufferSpan &first, BufferSpan &second);
+	uint32_t commitWrite(uint32_t length);
+};
+
+#endif
@@ -0,0 +1,158 @@
+/*
+	bufferwaiter.cpp - Implementation of the BufferWaiter class.
+	
+	Revision 0.
+	
+	Notes:
+			- 
+			
+	2026/10/17
+*/
+
+
+#include "bufferwaiter.h"
+
+#include <thread>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits>
+#include <ctime>
+#endif
+
+
+// Number of spins before spin-then-yield and futex waits back off.
+const uint32_t SPIN_LIMIT = 1000;
+
+
+// --- CPU RELAX ---
+// Hint to the CPU that we are in a spin loop.
+static inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	asm volatile("yield");
+#endif
+}
+
+
+// --- CONSTRUCTOR ---
+BufferWaiter::BufferWaiter(DataBufferWait strategy) {
+	this->strategy = strategy;
+	sequence = 0;
+	waiters = 0;
+}
+
+
+// --- SET STRATEGY ---
+// Set the way to wait. Must not be changed while a thread is waiting.
+void BufferWaiter::setStrategy(DataBufferWait strategy) {
+#ifndef __linux__
+	if (strategy == DB_WAIT_FUTEX) { strategy = DB_WAIT_CONDITION; }
+#endif
+	this->strategy = strategy;
+}
+
+
+// --- GET STRATEGY ---
+DataBufferWait BufferWaiter::getStrategy() {
+	return strategy;
+}
+
+
+// --- WAIT UNTIL ---
+// Wait until 'ready' returns true or the deadline passes. The condition is checked again after 
+// every notify() call.
+// Returns the result of the last condition check.
+bool BufferWaiter::waitUntil(const std::function<bool()> &ready, 
+										std::chrono::steady_clock::time_point deadline) {
+	if (ready()) { return true; }
+	
+	// Register as waiter. The sequentially consistent increment pairs with the fence in notify(),
+	// so that either the writer sees us waiting, or we see the state it published.
+	waiters.fetch_add(1, std::memory_order_seq_cst);
+	
+	bool result = false;
+	uint32_t spins = 0;
+	while (true) {
+		uint32_t seq = sequence.load(std::memory_order_acquire);
+		if (ready()) {
+			result = true;
+			break;
+		}
+		
+		if (std::chrono::steady_clock::now() >= deadline) { break; }
+		park(seq, deadline, spins);
+	}
+	
+	waiters.fetch_sub(1, std::memory_order_relaxed);
+	return result;
+}
+
+
+// --- PARK ---
+// Wait until the sequence changes from 'seq', using the configured strategy. May return early.
+void BufferWaiter::park(uint32_t seq, std::chrono::steady_clock::time_point deadline, 
+																			uint32_t &spins) {
+	switch (strategy) {
+		case DB_WAIT_SPIN:
+			cpuRelax();
+			break;
+		case DB_WAIT_SPIN_YIELD:
+			if (++spins < SPIN_LIMIT) 	{ cpuRelax(); }
+			else 						{ std::this_thread::yield(); }
+			break;
+#ifdef __linux__
+		case DB_WAIT_FUTEX: {
+			if (++spins < SPIN_LIMIT) {
+				cpuRelax();
+				break;
+			}
+			
+			// Sleep on the sequence word until notify() changes it, or the deadline passes.
+			std::chrono::nanoseconds left = deadline - std::chrono::steady_clock::now();
+			if (left.count() <= 0) { break; }
+			struct timespec ts;
+			ts.tv_sec = left.count() / 1000000000;
+			ts.tv_nsec = left.count() % 1000000000;
+			syscall(SYS_futex, reinterpret_cast<uint32_t*>(&sequence), FUTEX_WAIT_PRIVATE, seq, 
+																			&ts, 0, 0);
+			break;
+		}
+#endif
+		default: {
+			std::unique_lock<std::mutex> lk(mutex);
+			cv.wait_until(lk, deadline, [&] { 
+				return sequence.load(std::memory_order_acquire) != seq; 
+			});
+			break;
+		}
+	}
+}
+
+
+// --- NOTIFY ---
+// Wake up the waiting threads, if any. Call after publishing the state they wait for.
+void BufferWaiter::notify() {
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (waiters.load(std::memory_order_relaxed) == 0) { return; }
+	
+	sequence.fetch_add(1, std::memory_order_release);
+	switch (strategy) {
+		case DB_WAIT_SPIN:
+		case DB_WAIT_SPIN_YIELD:
+			break;
+#ifdef __linux__
+		case DB_WAIT_FUTEX:
+			syscall(SYS_futex, reinterpret_cast<uint32_t*>(&sequence), FUTEX_WAKE_PRIVATE, INT_MAX, 
+																			0, 0, 0);
+			break;
+#endif
+		default: {
+			std::lock_guard<std::mutex> lk(mutex);
+			cv.notify_all();
+			break;
+		}
+	}
+}
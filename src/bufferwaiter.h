@@ -0,0 +1,58 @@
+/*
+	bufferwaiter.h - Buffer Waiter header.
+	
+	Revision 0
+	
+	Features:
+			- Lets a reader wait for a condition that a writer signals.
+			- Selectable wait strategy: condition variable, busy-spin, spin-then-yield or 
+				futex park.
+			
+	Notes:
+			- The futex strategy is only available on Linux. Elsewhere it falls back to the 
+				condition variable.
+			
+	2026/10/17
+*/
+
+
+#ifndef BUFFERWAITER_H
+#define BUFFERWAITER_H
+
+
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+
+
+enum DataBufferWait {
+	DB_WAIT_CONDITION = 0,
+	DB_WAIT_SPIN,
+	DB_WAIT_SPIN_YIELD,
+	DB_WAIT_FUTEX
+};
+
+
+class BufferWaiter {
+	DataBufferWait strategy;
+	std::atomic<uint32_t> sequence;		// Bumped by notify() while there are waiters. Futex word.
+	std::atomic<uint32_t> waiters;		// Number of threads in waitUntil().
+	std::mutex mutex;
+	std::condition_variable cv;
+	
+	void park(uint32_t seq, std::chrono::steady_clock::time_point deadline, uint32_t &spins);
+	
+public:
+	BufferWaiter(DataBufferWait strategy = DB_WAIT_CONDITION);
+	
+	void setStrategy(DataBufferWait strategy);
+	DataBufferWait getStrategy();
+	bool waitUntil(const std::function<bool()> &ready, 
+										std::chrono::steady_clock::time_point deadline);
+	void notify();
+};
+
+#endif
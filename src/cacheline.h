@@ -0,0 +1,26 @@
+/*
+	cacheline.h - Cache line size header.
+	
+	Revision 0
+	
+	Features:
+			- Cache line size, shared by the buffers to keep reader and writer state apart.
+	
+	Notes:
+			- 64 bytes covers current x86-64 and most ARM cores.
+	
+	2026/10/17
+*/
+
+
+#ifndef CACHELINE_H
+#define CACHELINE_H
+
+
+#include <cstddef>
+
+
+// Size of a cache line, used to keep reader and writer state apart.
+const size_t SB_CACHE_LINE_SIZE = 64;
+
+#endif
@@ -0,0 +1,266 @@
+/*
+	chunkbuffer.cpp - Implementation of the ChunkBuffer class.
+	
+	Revision 0.
+	
+	Notes:
+			-
+	
+	2026/10/17
+*/
+
+
+//#define DEBUG 1
+
+#include "chunkbuffer.h"
+
+#include <cstring>
+#ifdef DEBUG
+#include <iostream>
+#endif
+
+
+// --- CONSTRUCTOR ---
+ChunkBuffer::ChunkBuffer() {
+	queue.slots = 0;
+	queue.size = 0;
+	queue.head = 0;
+	queue.tail = 0;
+	returns.slots = 0;
+	returns.size = 0;
+	returns.head = 0;
+	returns.tail = 0;
+	offset = 0;
+	bytesRead = 0;
+	bytesWritten = 0;
+}
+
+
+// --- DESTRUCTOR ---
+ChunkBuffer::~ChunkBuffer() {
+	cleanup();
+}
+
+
+// --- INIT ---
+// Initialises a new queue with room for 'slots' chunks. The return queue has the same size.
+// Returns false on error, otherwise true.
+bool ChunkBuffer::init(uint32_t slots) {
+	if (slots == 0) { return false; }
+	
+	cleanup();
+	queue.slots = new BufferChunk[slots];
+	queue.size = slots;
+	queue.head = 0;
+	queue.tail = 0;
+	returns.slots = new BufferChunk[slots];
+	returns.size = slots;
+	returns.head = 0;
+	returns.tail = 0;
+	
+	offset = 0;
+	bytesRead = 0;
+	bytesWritten = 0;
+	
+	return true;
+}
+
+
+// --- CLEAN UP ---
+// Delete the queues, along with the chunks in them.
+bool ChunkBuffer::cleanup() {
+	if (queue.slots != 0) {
+		delete[] queue.slots;
+		queue.slots = 0;
+	}
+	
+	if (returns.slots != 0) {
+		delete[] returns.slots;
+		returns.slots = 0;
+	}
+	
+	return true;
+}
+
+
+// --- NEXT SLOT ---
+// Returns the slot for the next chunk, or 0 if the queue is full. Writer side.
+BufferChunk* ChunkBuffer::nextSlot() {
+	if (queue.slots == 0) { return 0; }
+	
+	uint64_t loctail = queue.tail.load(std::memory_order_relaxed);
+	if (loctail - queue.head.load(std::memory_order_acquire) == queue.size) { return 0; }
+	
+	return &queue.slots[loctail % queue.size];
+}
+
+
+// --- PUBLISH ---
+// Make the chunk in the next slot visible to the reader. The release ordering publishes the 
+// chunk before the new tail. The byte count follows, so that it never covers unpublished chunks.
+void ChunkBuffer::publish(uint32_t length) {
+	queue.tail.store(queue.tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	bytesWritten.store(bytesWritten.load(std::memory_order_relaxed) + length, 
+																std::memory_order_release);
+}
+
+
+// --- WRITE ---
+// Queue a chunk, taking over the vector without copying its data.
+// Returns false if the queue is full or the chunk is empty, in which case the vector is left 
+// untouched. Otherwise true.
+bool ChunkBuffer::write(std::vector<uint8_t> &&data) {
+	if (data.empty() || data.size() > UINT32_MAX) { return false; }
+	
+	BufferChunk* slot = nextSlot();
+	if (slot == 0) { return false; }
+	
+	slot->vector = std::move(data);
+	slot->array.reset();
+	slot->length = slot->vector.size();
+	publish(slot->length);
+	
+	return true;
+}
+
+
+// --- WRITE ---
+// Queue a chunk of 'length' bytes, taking over the array without copying its data.
+// Returns false if the queue is full or the chunk is empty, in which case the array is left 
+// untouched. Otherwise true.
+bool ChunkBuffer::write(std::unique_ptr<uint8_t[]> &&data, uint32_t length) {
+	if (!data || length == 0) { return false; }
+	
+	BufferChunk* slot = nextSlot();
+	if (slot == 0) { return false; }
+	
+	slot->array = std::move(data);
+	slot->vector.clear();
+	slot->length = length;
+	publish(length);
+	
+	return true;
+}
+
+
+// --- RECLAIM ---
+// Take back a consumed chunk, to reuse its memory. Writer side. A vector keeps its capacity.
+// Returns false if no consumed chunk is waiting, otherwise true.
+bool ChunkBuffer::reclaim(BufferChunk &chunk) {
+	if (returns.slots == 0) { return false; }
+	
+	uint64_t lochead = returns.head.load(std::memory_order_relaxed);
+	if (lochead == returns.tail.load(std::memory_order_acquire)) { return false; }
+	
+	chunk = std::move(returns.slots[lochead % returns.size]);
+	returns.head.store(lochead + 1, std::memory_order_release);
+	
+	return true;
+}
+
+
+// --- RELEASE ---
+// Hand a consumed chunk back to the writer. If the writer does not reclaim chunks and the 
+// return queue is full, the chunk is freed instead. Reader side.
+void ChunkBuffer::release(BufferChunk &chunk) {
+	uint64_t loctail = returns.tail.load(std::memory_order_relaxed);
+	if (loctail - returns.head.load(std::memory_order_acquire) < returns.size) {
+		returns.slots[loctail % returns.size] = std::move(chunk);
+		returns.tail.store(loctail + 1, std::memory_order_release);
+	}
+	else {
+#ifdef DEBUG
+		std::cout << "ChunkBuffer: return queue full, freeing chunk." << std::endl;
+#endif
+		chunk.vector = std::vector<uint8_t>();
+		chunk.array.reset();
+	}
+	
+	chunk.length = 0;
+}
+
+
+// --- READABLE ---
+// Returns the number of unread bytes in the queued chunks.
+uint64_t ChunkBuffer::readable() {
+	return bytesWritten.load(std::memory_order_acquire) - bytesRead;
+}
+
+
+// --- READ ---
+// Copy up to 'len' unread bytes into the provided buffer, across chunks, and commit them.
+// Returns the number of bytes read.
+uint32_t ChunkBuffer::read(uint32_t len, uint8_t* bytes) {
+	if (queue.slots == 0) { return 0; }
+	
+	uint64_t lochead = queue.head.load(std::memory_order_relaxed);
+	uint64_t loctail = queue.tail.load(std::memory_order_acquire);
+	uint32_t start = offset;
+	uint32_t bytesCopied = 0;
+	while (bytesCopied < len && lochead < loctail) {
+		BufferChunk &chunk = queue.slots[lochead % queue.size];
+		uint32_t n = chunk.length - start;
+		if (len - bytesCopied < n) { n = len - bytesCopied; }
+		memcpy(bytes + bytesCopied, chunk.data() + start, n);
+		bytesCopied += n;
+		start = 0;
+		lochead++;
+	}
+	
+	return commit(bytesCopied);
+}
+
+
+// --- PEEK ---
+// Obtain the unread data without copying it, as one span per chunk, for up to 'count' chunks. 
+// The spans stay valid until the data is committed.
+// Returns the number of spans filled in.
+uint32_t ChunkBuffer::peek(BufferSpan* spans, uint32_t count) {
+	if (queue.slots == 0) { return 0; }
+	
+	uint64_t lochead = queue.head.load(std::memory_order_relaxed);
+	uint64_t loctail = queue.tail.load(std::memory_order_acquire);
+	uint32_t start = offset;
+	uint32_t filled = 0;
+	while (filled < count && lochead < loctail) {
+		BufferChunk &chunk = queue.slots[lochead % queue.size];
+		spans[filled].data = chunk.data() + start;
+		spans[filled].length = chunk.length - start;
+		filled++;
+		start = 0;
+		lochead++;
+	}
+	
+	return filled;
+}
+
+
+// --- COMMIT ---
+// Mark 'len' bytes obtained with peek() as read. Chunks that are read completely are handed 
+// back to the writer, and their slots freed.
+// Returns the number of bytes committed, which is limited to the number of unread bytes.
+uint32_t ChunkBuffer::commit(uint32_t len) {
+	if (queue.slots == 0) { return 0; }
+	
+	uint64_t lochead = queue.head.load(std::memory_order_relaxed);
+	uint64_t loctail = queue.tail.load(std::memory_order_acquire);
+	uint32_t bytesCommitted = 0;
+	while (bytesCommitted < len && lochead < loctail) {
+		BufferChunk &chunk = queue.slots[lochead % queue.size];
+		uint32_t n = chunk.length - offset;
+		if (len - bytesCommitted < n) { n = len - bytesCommitted; }
+		offset += n;
+		bytesCommitted += n;
+		
+		if (offset == chunk.length) {
+			release(chunk);
+			offset = 0;
+			lochead++;
+			queue.head.store(lochead, std::memory_order_release);
+		}
+	}
+	
+	bytesRead += bytesCommitted;
+	
+	return bytesCommitted;
+}
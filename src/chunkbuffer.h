@@ -0,0 +1,91 @@
+/*
+	chunkbuffer.h - Chunk Buffer header.
+	
+	Revision 0
+	
+	Features:
+			- Single producer, single consumer queue of producer-owned chunks. Chunks are moved
+				in, not copied.
+			- Reads and zero-copy views walk the queued chunks as one stream of bytes.
+			- Consumed chunks are handed back to the producer through a return queue, so that
+				it can reuse their memory.
+	
+	Notes:
+			- Lock-free, like StreamBuffer: the slot counters are owned by the writer and the 
+				reader respectively.
+			- The data is not contiguous across chunks. peek() returns one span per chunk.
+	
+	2026/10/17
+*/
+
+
+#ifndef CHUNKBUFFER_H
+#define CHUNKBUFFER_H
+
+
+#include "streambuffer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+// Chunk of stream data. The data is held by either the vector or the array.
+struct BufferChunk {
+	std::vector<uint8_t> vector;
+	std::unique_ptr<uint8_t[]> array;
+	uint32_t length;		// Number of data bytes.
+	
+	BufferChunk() : length(0) { }
+	uint8_t* data() { return array ? array.get() : vector.data(); }
+};
+
+
+class ChunkBuffer {
+	// Ring of chunk slots, with a counter for each side.
+	struct ChunkRing {
+		BufferChunk* slots;
+		uint32_t size;
+		uint8_t headPad[SB_CACHE_LINE_SIZE];
+		std::atomic<uint64_t> head;	// Slots taken. Only written by the taking side.
+		uint8_t tailPad[SB_CACHE_LINE_SIZE];
+		std::atomic<uint64_t> tail;	// Slots put. Only written by the putting side.
+	};
+	
+	ChunkRing queue;		// Chunks from the writer to the reader.
+	ChunkRing returns;		// Consumed chunks from the reader back to the writer.
+	
+	// Reader-owned state.
+	uint8_t readerPad[SB_CACHE_LINE_SIZE];
+	uint32_t offset;		// Read position in the chunk at the head of the queue.
+	uint64_t bytesRead;
+	
+	// Writer-owned state.
+	uint8_t writerPad[SB_CACHE_LINE_SIZE];
+	std::atomic<uint64_t> bytesWritten;
+	uint8_t sharedPad[SB_CACHE_LINE_SIZE];
+	
+	BufferChunk* nextSlot();
+	void publish(uint32_t length);
+	void release(BufferChunk &chunk);
+	
+public:
+	ChunkBuffer();
+	~ChunkBuffer();
+	
+	ChunkBuffer(const ChunkBuffer&) = delete;
+	ChunkBuffer& operator=(const ChunkBuffer&) = delete;
+	
+	bool init(uint32_t slots);
+	bool cleanup();
+	bool write(std::vector<uint8_t> &&data);
+	bool write(std::unique_ptr<uint8_t[]> &&data, uint32_t length);
+	bool reclaim(BufferChunk &chunk);
+	uint64_t readable();
+	uint32_t read(uint32_t len, uint8_t* bytes);
+	uint32_t peek(BufferSpan* spans, uint32_t count);
+	uint32_t commit(uint32_t len);
+};
+
+#endif
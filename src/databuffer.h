@@ -1,10 +1,14 @@
 /*
 	databuffer.h - Data Buffer header.
 	
-	Revision 0
+	Revision 1
 	
 	Features:
 			- Provides API for a ring buffer implementation.
+			- Static API wrapping a default StreamBuffer instance.
+			
+	Notes:
+			- Use StreamBuffer directly to run multiple streams in one process.
 			
 	2020/11/19, Maya Posch
 */
@@ -14,61 +18,30 @@
 #define DATABUFFER_H
 
 
-#include <atomic>
-#include <mutex>
-#include <functional>
-#include <condition_variable>
-#include <queue>
-#include <string>
-
-
-typedef std::function<void(uint32_t, int64_t)> SeekRequestCallback;
-
-enum DataBufferSeek {
-	DB_SEEK_START = 0,
-	DB_SEEK_CURRENT,
-	DB_SEEK_END
-};
+#include "streambuffer.h"
 
 
 class DataBuffer {
-	enum BufferState {
-		DBS_IDLE = 0,
-		DBS_BUFFERING,
-		DBS_SEEKING
-	};
-	
-	static uint8_t* buffer;		// Pointer to buffer.
-	static uint8_t* end;		// Pointer to buffer end (idx Nsize).
-	static uint8_t* front;		// Pointer to front of data in buffer (low).
-	static uint8_t* back;		// Pointer to back of data in buffer (last byte + 1).
-	static uint8_t* index;		// Pointer to first unread byte or buffer start.
-	static uint32_t capacity;	// Total capacity of buffer in bytes.
-	static uint32_t size;		// Total size of data in buffer in bytes.
-	static int64_t filesize;	// Size of the data being streamed, in bytes.
-	static std::atomic<uint32_t> unread;		// Number of unread bytes in the buffer.
-	static std::atomic<uint32_t> free;		// Number of free bytes in the buffer.
-	static uint32_t byteIndex;		// First unread byte index into the media file data.
-	static uint32_t byteIndexLow;	// Lowest media file byte index present in the buffer.
-	static uint32_t byteIndexHigh;	// Highest media file byte index present in the buffer.
-	static std::mutex bufferMutex;
-	static std::atomic<bool> eof;
-	static std::atomic<BufferState> state;
-	static SeekRequestCallback seekRequestCallback;
-	static std::condition_variable* dataRequestCV;
-	static std::mutex dataWaitMutex;
-	static std::condition_variable dataWaitCV;
-	static std::mutex seekRequestMutex;
-	static std::condition_variable seekRequestCV;
-	static std::atomic<bool> seekRequestPending;
-	static std::atomic<bool> resetRequest;
-	static uint32_t sessionHandle;		// Active session this buffer is associated with.
+	static StreamBuffer stream;		// Default instance used by the static API.
 	
 public:
+	static StreamBuffer& instance();
 	static bool init(uint32_t capacity);
 	static bool cleanup();
+	static void setAllocation(uint32_t flags, int node = -1);
+	static uint32_t getAllocation();
 	static void setSeekRequestCallback(SeekRequestCallback cb);
 	static void setDataRequestCondition(std::condition_variable* condition);
+	static void setRequestSize(uint32_t size);
+	static void setWatermarks(uint32_t low, uint32_t high);
+	static uint32_t getDataRequestSize();
+	static uint32_t getDataRequestGeneration();
+	static uint32_t getGeneration();
+	static void setHistorySize(uint32_t size);
+	static void setWaitStrategy(DataBufferWait strategy);
+	static void setRangeRequests(uint32_t count);
+	static void setProducer(ProducerCallback cb, RefillExecutor executor = nullptr);
+	static void setRecordFull(DataBufferFull mode, uint32_t timeout);
 	static void setSessionHandle(uint32_t handle);
 	static uint32_t getSessionHandle();
 	static void setFileSize(int64_t size);
@@ -77,15 +50,46 @@ public:
 	static void requestData();
 	static bool reset();
 	static int64_t seek(DataBufferSeek mode, int64_t offset);
+	static std::shared_future<int64_t> seekAsync(DataBufferSeek mode, int64_t offset);
+	static int64_t tell();
 	static bool seeking();
 	static uint32_t read(uint32_t len, uint8_t* bytes);
+	static uint32_t readAtLeast(uint32_t min, uint32_t len, uint8_t* bytes, 
+										std::chrono::steady_clock::time_point deadline);
+	static uint32_t readExact(uint32_t len, uint8_t* bytes, 
+										std::chrono::steady_clock::time_point deadline);
+	static uint32_t readToEof(uint32_t len, uint8_t* bytes, 
+										std::chrono::steady_clock::time_point deadline);
+	static uint32_t readv(const BufferSpan* segments, uint32_t count);
+	static uint32_t peek(BufferSpan &first, BufferSpan &second);
+	static uint32_t commit(uint32_t len);
+	static uint32_t skip(uint32_t len);
+	static int64_t drain(int fd, uint32_t max = UINT32_MAX);
 	static uint32_t write(std::string &data);
 	static uint32_t write(const char* data, uint32_t length);
+	static uint32_t write(const char* data, uint32_t length, uint32_t generation);
+	static uint32_t writev(const BufferSpan* segments, uint32_t count);
+	static uint32_t writev(const BufferSpan* segments, uint32_t count, uint32_t generation);
+	static uint32_t reserve(uint32_t max, BufferSpan &first, BufferSpan &second);
+	static uint32_t reserve(uint32_t max, BufferSpan &first, BufferSpan &second, 
+																	uint32_t generation);
+	static uint32_t commitWrite(uint32_t length);
+	static uint32_t commitWrite(uint32_t length, uint32_t generation);
+	static bool nextRange(RangeRequest &request);
+	static uint32_t reserveRange(const RangeRequest &request, BufferSpan &first, 
+																		BufferSpan &second);
+	static uint32_t completeRange(const RangeRequest &request, uint32_t length, 
+																bool end = false);
+	static bool reserveRecord(uint32_t length, BufferSpan &record);
+	static uint32_t commitRecordWrite(const BufferSpan &record);
+	static uint32_t writeRecord(const char* data, uint32_t length);
+	static uint32_t peekRecord(BufferSpan &record);
+	static uint32_t commitRecord();
+	static uint32_t readRecord(uint32_t len, uint8_t* bytes);
 	static void setEof(bool eof);
 	static bool isEof();
 	
-	static std::atomic<bool> dataRequestPending;
+	static std::atomic<bool>& dataRequestPending;
 };
 
 #endif
-
@@ -0,0 +1,243 @@
+/*
+	filesource.cpp - Implementation of the FileSource class.
+	
+	Revision 0.
+	
+	Notes:
+			-
+	
+	2026/10/17
+*/
+
+
+//#define DEBUG 1
+
+#include "filesource.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#ifdef DEBUG
+#include <iostream>
+#endif
+
+
+// Alignment of O_DIRECT reads: file offset, buffer address and length. Covers the logical
+// block size of common file systems and devices.
+const uint64_t FS_DIRECT_ALIGN = 4096;
+
+// Interval at which idle workers check whether the source was stopped, in milliseconds.
+const uint32_t FS_STOP_CHECK_MS = 100;
+
+
+// --- ALIGNED ---
+static inline bool aligned(uint64_t value) {
+	return (value % FS_DIRECT_ALIGN) == 0;
+}
+
+
+// --- CONSTRUCTOR ---
+FileSource::FileSource() {
+	fd = -1;
+	directFd = -1;
+	filesize = 0;
+	stream = 0;
+	running = false;
+	error = 0;
+}
+
+
+// --- DESTRUCTOR ---
+FileSource::~FileSource() {
+	close();
+}
+
+
+// --- OPEN ---
+// Open the file to serve. With 'direct', reads bypass the page cache where alignment allows.
+// If the file system does not support O_DIRECT, all reads go through the page cache.
+// Returns false on error, otherwise true.
+bool FileSource::open(const std::string &path, bool direct) {
+	close();
+	
+	fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) { return false; }
+	
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close();
+		return false;
+	}
+	
+	filesize = st.st_size;
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	
+	if (direct) {
+		directFd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+#ifdef DEBUG
+		if (directFd < 0) { std::cout << "FileSource: O_DIRECT not available." << std::endl; }
+#endif
+	}
+	
+	return true;
+}
+
+
+// --- CLOSE ---
+// Stop serving the buffer and close the file.
+bool FileSource::close() {
+	stop();
+	if (fd >= 0) {
+		::close(fd);
+		fd = -1;
+	}
+	
+	if (directFd >= 0) {
+		::close(directFd);
+		directFd = -1;
+	}
+	
+	filesize = 0;
+	
+	return true;
+}
+
+
+// --- IS DIRECT ---
+// Returns true if aligned reads bypass the page cache.
+bool FileSource::isDirect() {
+	return directFd >= 0;
+}
+
+
+// --- GET FILE SIZE ---
+int64_t FileSource::getFileSize() {
+	return filesize;
+}
+
+
+// --- GET ERROR ---
+// Returns the errno of the first failed read, or 0. A failed read ends the stream with EOF.
+int FileSource::getError() {
+	return error;
+}
+
+
+// --- START ---
+// Serve the data requests & seeks of a buffer from the file, with up to 'depth' reads in flight.
+// Puts the buffer in range request mode, and sets its file size, data request condition and
+// seek callback.
+// Returns false if no file is open, the depth is 0 or a buffer is already being served.
+bool FileSource::start(StreamBuffer &sb, uint32_t depth) {
+	if (fd < 0 || depth == 0 || !workers.empty()) { return false; }
+	
+	stream = &sb;
+	error = 0;
+	sb.setFileSize(filesize);
+	sb.setRangeRequests(depth);
+	sb.setDataRequestCondition(&requestCV);
+	sb.setSeekRequestCallback([](uint32_t, int64_t) { });	// Seeks are requested as ranges.
+	
+	running = true;
+	for (uint32_t i = 0; i < depth; ++i) {
+		workers.push_back(std::thread(&FileSource::work, this));
+	}
+	
+	return sb.start();
+}
+
+
+// --- STOP ---
+// Stop serving the buffer. Reads in flight are completed first.
+void FileSource::stop() {
+	if (workers.empty()) { return; }
+	
+	running = false;
+	for (std::thread &worker : workers) { worker.join(); }
+	workers.clear();
+	
+	stream->setDataRequestCondition(0);
+	stream = 0;
+}
+
+
+// --- WORK ---
+// Worker thread: fetch ranges from the file until stopped. The buffer wakes the worker up when 
+// it issues ranges. The wait times out only to check whether the source was stopped.
+void FileSource::work() {
+	while (running) {
+		RangeRequest request;
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + 
+											std::chrono::milliseconds(FS_STOP_CHECK_MS);
+		if (!stream->nextRange(request, deadline)) { continue; }
+	
+		BufferSpan first, second;
+		if (stream->reserveRange(request, first, second) == 0) {
+			stream->completeRange(request, 0);		// Out of date after a seek.
+			continue;
+		}
+	
+		int64_t bytesRead = readRange(request, first, second);
+		if (bytesRead < 0) {
+			int expected = 0;
+			error.compare_exchange_strong(expected, errno);
+#ifdef DEBUG
+			std::cout << "FileSource: read failed at " << request.offset << ", errno "
+						<< errno << std::endl;
+#endif
+			bytesRead = 0;
+		}
+	
+		// A short read means the end of the file, or an error. The buffer sets EOF once the 
+		// range is published, unless it is out of date, and does not request the rest again.
+		stream->completeRange(request, (uint32_t) bytesRead, bytesRead < request.length);
+	}
+}
+
+
+// --- READ RANGE ---
+// Read a range into its slot. Uses the O_DIRECT descriptor if the range is aligned.
+// Returns the number of bytes read, which is less than requested at the end of the file, or
+// -1 on error.
+int64_t FileSource::readRange(const RangeRequest &request, BufferSpan &first, BufferSpan &second) {
+	struct iovec iov[2];
+	iov[0].iov_base = first.data;
+	iov[0].iov_len = first.length;
+	iov[1].iov_base = second.data;
+	iov[1].iov_len = second.length;
+	int count = (second.length > 0) ? 2 : 1;
+	
+	int rfd = fd;
+	if (directFd >= 0 && aligned(request.offset) && aligned((uintptr_t) first.data) &&
+				aligned(first.length) && (second.length == 0 ||
+				(aligned((uintptr_t) second.data) && aligned(second.length)))) {
+		rfd = directFd;
+	}
+	
+	struct iovec* vec = iov;
+	uint32_t bytesRead = 0;
+	while (bytesRead < request.length) {
+		ssize_t res = preadv(rfd, vec, count, request.offset + bytesRead);
+		if (res < 0 && errno == EINTR) { continue; }
+		if (res < 0) { return -1; }
+		if (res == 0) { break; }
+	
+		// Move past the data read. The rest may no longer be aligned.
+		bytesRead += res;
+		rfd = fd;
+		while (count > 0 && (size_t) res >= vec->iov_len) {
+			res -= vec->iov_len;
+			vec++;
+			count--;
+		}
+	
+		if (count > 0) {
+			vec->iov_base = (uint8_t*) vec->iov_base + res;
+			vec->iov_len -= res;
+		}
+	}
+	
+	return bytesRead;
+}
@@ -0,0 +1,68 @@
+/*
+	filesource.h - File Source header.
+	
+	Revision 0
+	
+	Features:
+			- File-backed producer for a StreamBuffer, serving its data requests and seeks from
+				a local file.
+			- Configurable queue depth: that many reads are in flight at once, using the range
+				request mode of the buffer.
+			- Reads straight into the reserved space of the buffer, with preadv().
+			- Optional O_DIRECT, for reads that are aligned to the file system block size.
+	
+	Notes:
+			- Each queue slot is a worker thread doing blocking reads (Linux).
+			- With O_DIRECT, ranges whose file offset, buffer address or length are not aligned
+				are read through the page cache instead. This applies to the last range of the
+				file, and to ranges after a seek to an unaligned offset. Page-aligned buffer
+				capacities and request sizes keep the other ranges aligned.
+	
+	2026/10/17
+*/
+
+
+#ifndef FILESOURCE_H
+#define FILESOURCE_H
+
+
+#include "streambuffer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+class FileSource {
+	int fd;					// File opened for reads through the page cache.
+	int directFd;			// File opened with O_DIRECT, or -1.
+	int64_t filesize;
+	StreamBuffer* stream;
+	std::vector<std::thread> workers;
+	std::atomic<bool> running;
+	std::atomic<int> error;		// errno of the first failed read, or 0.
+	std::condition_variable requestCV;	// Data request condition, required by the buffer.
+	
+	void work();
+	int64_t readRange(const RangeRequest &request, BufferSpan &first, BufferSpan &second);
+
+public:
+	FileSource();
+	~FileSource();
+	
+	FileSource(const FileSource&) = delete;
+	FileSource& operator=(const FileSource&) = delete;
+	
+	bool open(const std::string &path, bool direct = false);
+	bool close();
+	bool isDirect();
+	int64_t getFileSize();
+	int getError();
+	bool start(StreamBuffer &sb, uint32_t depth);
+	void stop();
+};
+
+#endif
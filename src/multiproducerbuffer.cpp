@@ -0,0 +1,222 @@
+/*
+	multiproducerbuffer.cpp - Implementation of the MultiProducerBuffer class.
+	
+	Revision 0.
+	
+	Notes:
+			-
+	
+	2026/10/17
+*/
+
+
+//#define DEBUG 1
+
+#include "multiproducerbuffer.h"
+
+#include <cstring>
+#ifdef DEBUG
+#include <iostream>
+#endif
+
+
+// Slot size. Chunks start on a slot boundary.
+const uint32_t MPB_SLOT_SIZE = SB_CACHE_LINE_SIZE;
+
+// Commit flag of the padding in front of a chunk that wrapped around.
+const uint32_t MPB_PADDING = 0x80000000;
+
+
+// --- ROUND UP ---
+static inline uint32_t roundUp(uint32_t length) {
+	return (length + MPB_SLOT_SIZE - 1) & ~(MPB_SLOT_SIZE - 1);
+}
+
+
+// --- CONSTRUCTOR ---
+MultiProducerBuffer::MultiProducerBuffer() {
+	buffer = 0;
+	capacity = 0;
+	commits = 0;
+	head = 0;
+	reserveTail = 0;
+}
+
+
+// --- DESTRUCTOR ---
+MultiProducerBuffer::~MultiProducerBuffer() {
+	cleanup();
+}
+
+
+// --- INIT ---
+// Initialises a new buffer. The capacity must be a multiple of the slot size (64 bytes).
+// Returns false on error, otherwise true.
+bool MultiProducerBuffer::init(uint32_t capacity) {
+	if (capacity == 0 || capacity % MPB_SLOT_SIZE != 0 || capacity >= MPB_PADDING) {
+		return false;
+	}
+	
+	cleanup();
+	buffer = new uint8_t[capacity];
+	this->capacity = capacity;
+	
+	uint32_t slots = capacity / MPB_SLOT_SIZE;
+	commits = new std::atomic<uint32_t>[slots];
+	for (uint32_t i = 0; i < slots; ++i) { commits[i] = 0; }
+	
+	head = 0;
+	reserveTail = 0;
+	
+	return true;
+}
+
+
+// --- CLEAN UP ---
+bool MultiProducerBuffer::cleanup() {
+	if (buffer != 0) {
+		delete[] buffer;
+		buffer = 0;
+	}
+	
+	if (commits != 0) {
+		delete[] commits;
+		commits = 0;
+	}
+	
+	return true;
+}
+
+
+// --- RESERVE ---
+// Claim a contiguous slot for a chunk of 'length' bytes. Can be called by any number of
+// producers at once. The chunk must be published with commitWrite(). A chunk that only fits 
+// at the front of an empty buffer pads the end of the buffer and fails. It fits once the reader
+// has skipped the padding.
+// Returns false if the buffer does not have enough free space, otherwise true.
+bool MultiProducerBuffer::reserve(uint32_t length, BufferSpan &chunk) {
+	uint32_t size = roundUp(length);
+	if (length == 0 || size > capacity) { return false; }
+	
+	uint64_t loctail = reserveTail.load(std::memory_order_relaxed);
+	uint32_t pad;
+	for (;;) {
+		// If the chunk does not fit before the end of the buffer, pad up to the end.
+		uint32_t offset = loctail % capacity;
+		pad = (capacity - offset < size) ? capacity - offset : 0;
+		uint64_t newtail = loctail + pad + size;
+		uint64_t lochead = head.load(std::memory_order_acquire);
+		if (newtail - lochead > capacity) {
+			// The padding and the chunk together may never fit. If the buffer is empty, reserve 
+			// just the padding, so that the reader moves on to the front and the chunk fits 
+			// once it has.
+			if (pad == 0 || loctail != lochead) { return false; }
+			if (reserveTail.compare_exchange_weak(loctail, loctail + pad, 
+										std::memory_order_relaxed, std::memory_order_relaxed)) {
+				commits[offset / MPB_SLOT_SIZE].store(pad | MPB_PADDING, std::memory_order_release);
+				return false;
+			}
+			
+			continue;
+		}
+	
+		if (reserveTail.compare_exchange_weak(loctail, newtail, std::memory_order_relaxed,
+																std::memory_order_relaxed)) {
+			break;
+		}
+	}
+	
+	if (pad > 0) {
+#ifdef DEBUG
+		std::cout << "MultiProducerBuffer: padding " << pad << " bytes at " << loctail << std::endl;
+#endif
+		commits[(loctail % capacity) / MPB_SLOT_SIZE].store(pad | MPB_PADDING,
+																std::memory_order_release);
+		loctail += pad;
+	}
+	
+	chunk.data = buffer + (loctail % capacity);
+	chunk.length = length;
+	
+	return true;
+}
+
+
+// --- COMMIT WRITE ---
+// Publish a chunk obtained with reserve(). The release ordering makes the data visible to the
+// reader before the commit flag is.
+void MultiProducerBuffer::commitWrite(const BufferSpan &chunk) {
+	commits[(chunk.data - buffer) / MPB_SLOT_SIZE].store(chunk.length, std::memory_order_release);
+}
+
+
+// --- WRITE ---
+// Copy a chunk of 'length' bytes into the buffer and publish it.
+// Returns false if the buffer does not have enough free space, otherwise true.
+bool MultiProducerBuffer::write(const char* data, uint32_t length) {
+	BufferSpan chunk;
+	if (!reserve(length, chunk)) { return false; }
+	
+	memcpy(chunk.data, data, length);
+	commitWrite(chunk);
+	
+	return true;
+}
+
+
+// --- NEXT ---
+// Skip over padding to the next chunk.
+// Returns the length of the next chunk if it is committed, otherwise 0.
+uint32_t MultiProducerBuffer::next(uint32_t &slot) {
+	for (;;) {
+		uint64_t lochead = head.load(std::memory_order_relaxed);
+		slot = (lochead % capacity) / MPB_SLOT_SIZE;
+		uint32_t flag = commits[slot].load(std::memory_order_acquire);
+		if ((flag & MPB_PADDING) == 0) { return flag; }
+	
+		// Clear the flag before freeing the slot, so that it reads as uncommitted when the
+		// slot is reserved again.
+		commits[slot].store(0, std::memory_order_relaxed);
+		head.store(lochead + (flag & ~MPB_PADDING), std::memory_order_release);
+	}
+}
+
+
+// --- PEEK ---
+// Obtain the next chunk without copying it. It stays valid until commit() is called.
+// Returns the length of the chunk, or 0 if the next chunk is not committed yet.
+uint32_t MultiProducerBuffer::peek(BufferSpan &chunk) {
+	uint32_t slot;
+	chunk.length = next(slot);
+	chunk.data = buffer + (size_t) slot * MPB_SLOT_SIZE;
+	
+	return chunk.length;
+}
+
+
+// --- COMMIT ---
+// Mark the chunk obtained with peek() as read, freeing its slot.
+// Returns the length of the chunk, or 0 if no chunk was ready.
+uint32_t MultiProducerBuffer::commit() {
+	uint32_t slot;
+	uint32_t length = next(slot);
+	if (length == 0) { return 0; }
+	
+	commits[slot].store(0, std::memory_order_relaxed);
+	head.store(head.load(std::memory_order_relaxed) + roundUp(length), std::memory_order_release);
+	
+	return length;
+}
+
+
+// --- READ ---
+// Copy the next chunk into the provided buffer, if it fits in 'len' bytes.
+// Returns the length of the chunk, or 0 if no chunk is ready or it does not fit.
+uint32_t MultiProducerBuffer::read(uint32_t len, uint8_t* bytes) {
+	BufferSpan chunk;
+	if (peek(chunk) == 0 || chunk.length > len) { return 0; }
+	
+	memcpy(bytes, chunk.data, chunk.length);
+	
+	return commit();
+}
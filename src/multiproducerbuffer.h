@@ -0,0 +1,67 @@
+/*
+	multiproducerbuffer.h - Multi Producer Buffer header.
+	
+	Revision 0
+	
+	Features:
+			- Multiple producer, single consumer ring buffer of whole chunks.
+			- Lock-free reservation: each producer claims a contiguous slot with
+				compare-and-swap, fills it and commits it independently.
+			- The reader gets the chunks in reservation order.
+	
+	Notes:
+			- Slots are aligned to cache lines, so producers don't share cache lines. A chunk
+				that does not fit before the end of the buffer is placed at the front, with
+				padding in between. If that only fits in an empty buffer, the padding is reserved
+				first, and the chunk fits once the reader has skipped it.
+			- A chunk that is reserved but not committed yet holds up the reader.
+	
+	2026/10/17
+*/
+
+
+#ifndef MULTIPRODUCERBUFFER_H
+#define MULTIPRODUCERBUFFER_H
+
+
+#include "streambuffer.h"
+
+#include <atomic>
+#include <cstdint>
+
+
+class MultiProducerBuffer {
+	// Read-only after init(), shared by readers and writers.
+	uint8_t* buffer;		// Pointer to buffer.
+	uint32_t capacity;		// Total capacity of buffer in bytes. Multiple of the slot size.
+	std::atomic<uint32_t>* commits;	// Per slot: committed chunk length & flags, or 0.
+	
+	// Reader-owned state.
+	uint8_t readerPad[SB_CACHE_LINE_SIZE];
+	std::atomic<uint64_t> head;	// Start of the next chunk to read. Only written by the reader.
+	
+	// Writer state, shared by all producers.
+	uint8_t writerPad[SB_CACHE_LINE_SIZE];
+	std::atomic<uint64_t> reserveTail;	// End of the reserved slots.
+	uint8_t sharedPad[SB_CACHE_LINE_SIZE];
+	
+	uint32_t next(uint32_t &slot);
+
+public:
+	MultiProducerBuffer();
+	~MultiProducerBuffer();
+	
+	MultiProducerBuffer(const MultiProducerBuffer&) = delete;
+	MultiProducerBuffer& operator=(const MultiProducerBuffer&) = delete;
+	
+	bool init(uint32_t capacity);
+	bool cleanup();
+	bool reserve(uint32_t length, BufferSpan &chunk);
+	void commitWrite(const BufferSpan &chunk);
+	bool write(const char* data, uint32_t length);
+	uint32_t peek(BufferSpan &chunk);
+	uint32_t commit();
+	uint32_t read(uint32_t len, uint8_t* bytes);
+};
+
+#endif
@@ -0,0 +1,263 @@
+/*
+	ringbuffer.h - Ring Buffer template header.
+	
+	Revision 0
+	
+	Features:
+			- Header-only single producer, single consumer ring buffer of elements of type T.
+			- Capacity fixed at compile time. Must be a power of two, so that indices are
+				masked instead of compared against the buffer end.
+			- Monotonic 64-bit head & tail counters, owned by the reader & writer respectively,
+				on cache lines of their own.
+			- Zero-copy reserve/commitWrite & peek/commit, like StreamBuffer.
+	
+	Notes:
+			- Elements must be trivially copyable, they are moved with memcpy().
+			- The elements are stored inline. Allocate large buffers on the heap.
+	
+	2026/10/17
+*/
+
+
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+
+#include "cacheline.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+
+template <typename T, uint32_t Capacity>
+class RingBuffer {
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+											"RingBuffer capacity must be a power of two.");
+	static_assert(std::is_trivially_copyable<T>::value,
+											"RingBuffer elements must be trivially copyable.");
+	
+	static constexpr uint32_t mask = Capacity - 1;
+	
+	// Reader-owned state.
+	uint8_t readerPad[SB_CACHE_LINE_SIZE];
+	std::atomic<uint64_t> head;	// Elements read.
+	uint64_t tailCache;		// Reader's copy of 'tail'.
+	
+	// Writer-owned state.
+	uint8_t writerPad[SB_CACHE_LINE_SIZE];
+	std::atomic<uint64_t> tail;	// Elements written.
+	uint64_t headCache;		// Writer's copy of 'head'.
+	uint8_t sharedPad[SB_CACHE_LINE_SIZE];
+	
+	T elements[Capacity];
+	
+public:
+	// Contiguous section of the ring, used by the zero-copy API.
+	struct Span {
+		T* data;
+		uint32_t length;
+	};
+	
+	RingBuffer();
+	
+	RingBuffer(const RingBuffer&) = delete;
+	RingBuffer& operator=(const RingBuffer&) = delete;
+	
+	// --- CAPACITY ---
+	static constexpr uint32_t capacity() { return Capacity; }
+	
+	// --- STORAGE SIZE ---
+	// Bytes of element storage.
+	static constexpr size_t storageSize() { return sizeof(T) * Capacity; }
+	
+	// --- INDEX ---
+	// Position of a counter value in the ring.
+	static constexpr uint32_t index(uint64_t counter) { return (uint32_t) (counter & mask); }
+	
+	void reset();
+	uint32_t readable();
+	uint32_t writable();
+	bool push(const T &item);
+	bool pop(T &item);
+	uint32_t write(const T* items, uint32_t count);
+	uint32_t read(T* items, uint32_t count);
+	uint32_t reserve(uint32_t max, Span &first, Span &second);
+	uint32_t commitWrite(uint32_t count);
+	uint32_t peek(Span &first, Span &second);
+	uint32_t commit(uint32_t count);
+};
+
+
+// --- CONSTRUCTOR ---
+template <typename T, uint32_t Capacity>
+RingBuffer<T, Capacity>::RingBuffer() {
+	reset();
+}
+
+
+// --- RESET ---
+// Empty the buffer. Neither the reader nor the writer may be active.
+template <typename T, uint32_t Capacity>
+void RingBuffer<T, Capacity>::reset() {
+	head = 0;
+	tailCache = 0;
+	tail = 0;
+	headCache = 0;
+}
+
+
+// --- READABLE ---
+// Returns the number of unread elements. Reader side.
+template <typename T, uint32_t Capacity>
+uint32_t RingBuffer<T, Capacity>::readable() {
+	tailCache = tail.load(std::memory_order_acquire);
+	return (uint32_t) (tailCache - head.load(std::memory_order_relaxed));
+}
+
+
+// --- WRITABLE ---
+// Returns the number of free elements. Writer side.
+template <typename T, uint32_t Capacity>
+uint32_t RingBuffer<T, Capacity>::writable() {
+	headCache = head.load(std::memory_order_acquire);
+	return Capacity - (uint32_t) (tail.load(std::memory_order_relaxed) - headCache);
+}
+
+
+// --- PUSH ---
+// Write a single element.
+// Returns false if the buffer is full, otherwise true.
+template <typename T, uint32_t Capacity>
+bool RingBuffer<T, Capacity>::push(const T &item) {
+	uint64_t loctail = tail.load(std::memory_order_relaxed);
+	if (loctail - headCache == Capacity && writable() == 0) { return false; }
+	
+	elements[index(loctail)] = item;
+	tail.store(loctail + 1, std::memory_order_release);
+	
+	return true;
+}
+
+
+// --- POP ---
+// Read a single element.
+// Returns false if the buffer is empty, otherwise true.
+template <typename T, uint32_t Capacity>
+bool RingBuffer<T, Capacity>::pop(T &item) {
+	uint64_t lochead = head.load(std::memory_order_relaxed);
+	if (lochead == tailCache && readable() == 0) { return false; }
+	
+	item = elements[index(lochead)];
+	head.store(lochead + 1, std::memory_order_release);
+	
+	return true;
+}
+
+
+// --- RESERVE ---
+// Obtain up to 'max' free elements to write into directly. The second span covers the part
+// that wraps around to the front of the ring, and is empty if there is no wrap.
+// Returns the total number of elements in both spans.
+template <typename T, uint32_t Capacity>
+uint32_t RingBuffer<T, Capacity>::reserve(uint32_t max, Span &first, Span &second) {
+	uint64_t loctail = tail.load(std::memory_order_relaxed);
+	uint32_t locfree = Capacity - (uint32_t) (loctail - headCache);
+	if (locfree < max) { locfree = writable(); }
+	if (max < locfree) { locfree = max; }
+	
+	uint32_t start = index(loctail);
+	uint32_t single = Capacity - start;
+	if (locfree < single) { single = locfree; }
+	
+	first.data = elements + start;
+	first.length = single;
+	second.data = elements;
+	second.length = locfree - single;
+	
+	return locfree;
+}
+
+
+// --- COMMIT WRITE ---
+// Publish 'count' elements written into the spans obtained with reserve().
+// Returns the number of elements committed, which is limited to the number of free elements.
+template <typename T, uint32_t Capacity>
+uint32_t RingBuffer<T, Capacity>::commitWrite(uint32_t count) {
+	uint64_t loctail = tail.load(std::memory_order_relaxed);
+	uint32_t locfree = Capacity - (uint32_t) (loctail - headCache);
+	if (count > locfree) { count = locfree; }
+	
+	tail.store(loctail + count, std::memory_order_release);
+	
+	return count;
+}
+
+
+// --- WRITE ---
+// Copy up to 'count' elements into the buffer.
+// Returns the number of elements written.
+template <typename T, uint32_t Capacity>
+uint32_t RingBuffer<T, Capacity>::write(const T* items, uint32_t count) {
+	Span first, second;
+	uint32_t n = reserve(count, first, second);
+	memcpy(first.data, items, first.length * sizeof(T));
+	memcpy(second.data, items + first.length, second.length * sizeof(T));
+	
+	return commitWrite(n);
+}
+
+
+// --- PEEK ---
+// Obtain the unread elements without copying them, like reserve().
+// Returns the total number of elements in both spans.
+template <typename T, uint32_t Capacity>
+uint32_t RingBuffer<T, Capacity>::peek(Span &first, Span &second) {
+	uint32_t locunread = readable();
+	uint32_t start = index(head.load(std::memory_order_relaxed));
+	uint32_t single = Capacity - start;
+	if (locunread < single) { single = locunread; }
+	
+	first.data = elements + start;
+	first.length = single;
+	second.data = elements;
+	second.length = locunread - single;
+	
+	return locunread;
+}
+
+
+// --- COMMIT ---
+// Mark 'count' elements obtained with peek() as read.
+// Returns the number of elements committed, which is limited to the number of unread elements.
+template <typename T, uint32_t Capacity>
+uint32_t RingBuffer<T, Capacity>::commit(uint32_t count) {
+	uint64_t lochead = head.load(std::memory_order_relaxed);
+	uint32_t locunread = (uint32_t) (tailCache - lochead);
+	if (count > locunread) { locunread = readable(); }
+	if (count > locunread) { count = locunread; }
+	
+	head.store(lochead + count, std::memory_order_release);
+	
+	return count;
+}
+
+
+// --- READ ---
+// Copy up to 'count' elements out of the buffer.
+// Returns the number of elements read.
+template <typename T, uint32_t Capacity>
+uint32_t RingBuffer<T, Capacity>::read(T* items, uint32_t count) {
+	Span first, second;
+	uint32_t n = peek(first, second);
+	if (count < n) { n = count; }
+	
+	uint32_t single = (first.length < n) ? first.length : n;
+	memcpy(items, first.data, single * sizeof(T));
+	memcpy(items + single, second.data, (n - single) * sizeof(T));
+	
+	return commit(n);
+}
+
+#endif
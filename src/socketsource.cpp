@@ -0,0 +1,193 @@
+/*
+	socketsource.cpp - Implementation of the SocketSource class.
+	
+	Revision 0.
+	
+	Notes:
+			-
+	
+	2026/10/17
+*/
+
+
+//#define DEBUG 1
+
+#include "socketsource.h"
+
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#ifdef DEBUG
+#include <iostream>
+#endif
+
+
+// --- CONSTRUCTOR ---
+SocketSource::SocketSource() {
+	fd = -1;
+	wakeFd = -1;
+	stream = 0;
+	running = false;
+	error = 0;
+}
+
+
+// --- DESTRUCTOR ---
+SocketSource::~SocketSource() {
+	stop();
+}
+
+
+// --- START ---
+// Fill a buffer from a connected stream socket, on a receive thread of our own. Sets the data 
+// request condition of the buffer.
+// Returns false if the socket is invalid, a buffer is already being filled, or on error.
+bool SocketSource::start(StreamBuffer &sb, int fd) {
+	if (fd < 0 || receiver.joinable()) { return false; }
+	
+	wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (wakeFd < 0) { return false; }
+	
+	this->fd = fd;
+	stream = &sb;
+	error = 0;
+	sb.setDataRequestCondition(&requestCV);
+	
+	running = true;
+	receiver = std::thread(&SocketSource::receive, this);
+	
+	return sb.start();
+}
+
+
+// --- STOP ---
+// Stop filling the buffer. The socket stays open.
+void SocketSource::stop() {
+	if (!receiver.joinable()) { return; }
+	
+	running = false;
+	uint64_t one = 1;
+	if (write(wakeFd, &one, sizeof(one)) < 0) {
+		// Only fails on a full counter, which one write per stop can't reach.
+#ifdef DEBUG
+		std::cout << "SocketSource: wake-up failed, errno " << errno << std::endl;
+#endif
+	}
+	
+	requestCV.notify_all();
+	receiver.join();
+	
+	close(wakeFd);
+	wakeFd = -1;
+	stream->setDataRequestCondition(0);
+	stream = 0;
+	fd = -1;
+}
+
+
+// --- IS RUNNING ---
+// Returns false once the stream has ended, by shutdown of the peer or an error.
+bool SocketSource::isRunning() {
+	return running;
+}
+
+
+// --- GET ERROR ---
+// Returns the errno of a failed receive, or 0. A failed receive ends the stream with EOF.
+int SocketSource::getError() {
+	return error;
+}
+
+
+// --- RECEIVE ---
+// Receive thread: wait until the buffer has free space and the socket has data, then receive 
+// the data into the free space. The buffer signals the request condition as the reader frees 
+// space. The wait times out, as it does not take our mutex.
+// The size of a data request is not used: the sender decides how much data arrives, so the 
+// request only wakes the thread up, and everything ready is received into all free space.
+void SocketSource::receive() {
+	struct pollfd fds[2];
+	fds[0].fd = fd;
+	fds[0].events = POLLIN;
+	fds[1].fd = wakeFd;
+	fds[1].events = POLLIN;
+	
+	while (running) {
+		BufferSpan first, second;
+		if (stream->reserve(UINT32_MAX, first, second) == 0) {
+			std::unique_lock<std::mutex> lk(requestMutex);
+			requestCV.wait_for(lk, std::chrono::milliseconds(10));
+			continue;
+		}
+		
+		if (poll(fds, 2, -1) < 0) {
+			if (errno == EINTR) { continue; }
+			error = errno;
+			break;
+		}
+		
+		if (!running) { break; }
+		if (fds[0].revents == 0) { continue; }
+		
+		bool ended = false;
+		uint32_t bytesReceived = receiveInto(first, second, ended);
+		if (bytesReceived > 0) { stream->commitWrite(bytesReceived); }
+		if (ended) {
+			// Orderly shutdown or error: the stream has ended.
+#ifdef DEBUG
+			std::cout << "SocketSource: end of stream, error " << error << std::endl;
+#endif
+			stream->setEof(true);
+			break;
+		}
+	}
+	
+	running = false;
+}
+
+
+// --- RECEIVE INTO ---
+// Receive into the free spans until they are full or the socket has no more data ready. Sets 
+// 'ended' on orderly shutdown by the peer or an error.
+// Returns the number of bytes received.
+uint32_t SocketSource::receiveInto(BufferSpan &first, BufferSpan &second, bool &ended) {
+	struct iovec iov[2];
+	iov[0].iov_base = first.data;
+	iov[0].iov_len = first.length;
+	iov[1].iov_base = second.data;
+	iov[1].iov_len = second.length;
+	
+	struct msghdr msg = {};
+	msg.msg_iov = iov;
+	msg.msg_iovlen = (second.length > 0) ? 2 : 1;
+	
+	uint32_t bytesReceived = 0;
+	while (msg.msg_iovlen > 0) {
+		ssize_t res = recvmsg(fd, &msg, MSG_DONTWAIT);
+		if (res < 0 && errno == EINTR) { continue; }
+		if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) { break; }
+		if (res < 0) { error = errno; }
+		if (res <= 0) {
+			ended = true;
+			break;
+		}
+		
+		// Move past the data received.
+		bytesReceived += res;
+		while (msg.msg_iovlen > 0 && (size_t) res >= msg.msg_iov->iov_len) {
+			res -= msg.msg_iov->iov_len;
+			msg.msg_iov++;
+			msg.msg_iovlen--;
+		}
+		
+		if (msg.msg_iovlen > 0) {
+			msg.msg_iov->iov_base = (uint8_t*) msg.msg_iov->iov_base + res;
+			msg.msg_iov->iov_len -= res;
+		}
+	}
+	
+	return bytesReceived;
+}
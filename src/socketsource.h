@@ -0,0 +1,65 @@
+/*
+	socketsource.h - Socket Source header.
+	
+	Revision 0
+	
+	Features:
+			- Producer for a StreamBuffer, filling it from a connected TCP or Unix domain
+				stream socket.
+			- Non-blocking recvmsg() straight into the free spans of the buffer. Everything
+				the socket has ready is received before a single commit.
+			- Backpressure: receives no more than the free space, and waits for a data request
+				when the buffer is full. The sender is then held up by the socket buffers.
+			- Sets EOF on orderly shutdown by the peer.
+	
+	Notes:
+			- Linux, uses poll() and an eventfd to stop the receive thread.
+			- The socket is not closed by this class.
+			- A socket stream can't seek. Seeks within the buffered data still work.
+			- Data requests only wake up the receive thread. Their size is not used, as a
+				socket can't be asked for a given amount of data.
+	
+	2026/10/17
+*/
+
+
+#ifndef SOCKETSOURCE_H
+#define SOCKETSOURCE_H
+
+
+#include "streambuffer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+
+class SocketSource {
+	int fd;					// Connected socket.
+	int wakeFd;				// eventfd used to stop the receive thread.
+	StreamBuffer* stream;
+	std::thread receiver;
+	std::atomic<bool> running;
+	std::atomic<int> error;		// errno of a failed receive, or 0.
+	std::condition_variable requestCV;	// Signalled by the buffer when it requests data.
+	std::mutex requestMutex;
+	
+	void receive();
+	uint32_t receiveInto(BufferSpan &first, BufferSpan &second, bool &ended);
+	
+public:
+	SocketSource();
+	~SocketSource();
+	
+	SocketSource(const SocketSource&) = delete;
+	SocketSource& operator=(const SocketSource&) = delete;
+	
+	bool start(StreamBuffer &sb, int fd);
+	void stop();
+	bool isRunning();
+	int getError();
+};
+
+#endif
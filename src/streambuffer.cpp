@@ -0,0 +1,2010 @@
+/*
+	streambuffer.cpp - Implementation of the StreamBuffer class.
+	
+	Revision 0.
+	
+	Notes:
+			- Moved from the static DataBuffer class, which now wraps a default instance.
+			
+	2026/10/17
+*/
+
+
+//#define DEBUG 1
+
+#include "streambuffer.h"
+
+#include <cstring>
+#include <chrono>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+#ifdef DEBUG
+#include <iostream>
+#endif
+
+
+// Size of the length prefix of a record.
+const uint32_t SB_RECORD_HEADER = sizeof(uint32_t);
+
+// Record length marking the rest of the buffer as padding.
+const uint32_t SB_RECORD_PADDING = UINT32_MAX;
+
+// Size of an explicit huge page. The default on x86-64, and on arm64 with 4 kB pages.
+const size_t SB_HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// NUMA memory policy for mbind(), from <numaif.h>, which is not always installed.
+const int SB_MPOL_BIND = 2;
+const unsigned SB_MPOL_MF_MOVE = 2;
+
+
+// --- SEGMENTS LENGTH ---
+// Returns the total length of a list of segments, limited to what fits in 32 bits.
+static uint32_t segmentsLength(const BufferSpan* segments, uint32_t count) {
+	uint64_t total = 0;
+	for (uint32_t i = 0; i < count; ++i) { total += segments[i].length; }
+	
+	return (total > UINT32_MAX) ? UINT32_MAX : (uint32_t) total;
+}
+
+
+// --- COPY SEGMENTS ---
+// Copy between the two spans of a ring section and a list of segments, in order, until either 
+// runs out. 'toRing' selects the direction.
+// Returns the number of bytes copied.
+static uint32_t copySegments(const BufferSpan &first, const BufferSpan &second, 
+							const BufferSpan* segments, uint32_t count, bool toRing) {
+	const BufferSpan* span = &first;
+	uint32_t spanOffset = 0;
+	uint32_t copied = 0;
+	for (uint32_t i = 0; i < count; ++i) {
+		uint32_t segOffset = 0;
+		while (segOffset < segments[i].length) {
+			if (spanOffset == span->length) {
+				if (span == &second) { return copied; }
+				span = &second;
+				spanOffset = 0;
+				continue;
+			}
+			
+			uint32_t n = segments[i].length - segOffset;
+			if (span->length - spanOffset < n) { n = span->length - spanOffset; }
+			if (toRing) { memcpy(span->data + spanOffset, segments[i].data + segOffset, n); }
+			else 		{ memcpy(segments[i].data + segOffset, span->data + spanOffset, n); }
+			spanOffset += n;
+			segOffset += n;
+			copied += n;
+		}
+	}
+	
+	return copied;
+}
+
+
+// --- CONSTRUCTOR ---
+// The wait strategy determines how the reader waits for data and request completions.
+StreamBuffer::StreamBuffer(DataBufferWait strategy) : waiter(strategy), refillWaiter(strategy),
+																	spaceWaiter(strategy) {
+	buffer = 0;
+	mirrored = false;
+	end = 0;
+	capacity = 0;
+	mapSize = 0;
+	allocated = 0;
+	allocFlags = DB_ALLOC_DEFAULT;
+	allocNode = -1;
+	head = 0;
+	low = 0;
+	tailCache = 0;
+	index = 0;
+	byteIndex = 0;
+	historyRetain = 0;
+	tail = 0;
+	lowCache = 0;
+	back = 0;
+	filesize = 0;
+	historySize = 0;
+	eof = false;
+	state = DBS_IDLE;
+	seekRequestCallback = 0;
+	dataRequestCV = 0;
+	requestSize = 204800;
+	lowWatermark = UINT32_MAX;
+	highWatermark = UINT32_MAX;
+	dataRequestSize = 0;
+	seekRequestPending = false;
+	seekPending = false;
+	seekTarget = 0;
+	seekGeneration = 0;
+	seekDeferred = false;
+	seekOrigin = 0;
+	seekOriginGeneration = 0;
+	taggedWrites = false;
+	generation = 0;
+	dataRequestGeneration = 0;
+	rebasePending = false;
+	drainFd = -1;
+	drainSocket = false;
+	lowFloor = 0;
+	writerGeneration = 0;
+	generationBase = 0;
+	generationOffset = 0;
+	sessionHandle = 0;
+	maxRanges = 0;
+	rangeGeneration = 0;
+	rangeEnd = 0;
+	rangeOffset = 0;
+	nextRangeId = 0;
+	producer = nullptr;
+	refillExecutor = nullptr;
+	refillRunning = false;
+	refillQueued = false;
+	refillTasks = 0;
+	recordFull = DB_FULL_FAIL;
+	recordTimeout = 0;
+	dataRequestPending = false;
+}
+
+
+// --- DESTRUCTOR ---
+StreamBuffer::~StreamBuffer() {
+	cleanup();
+}
+
+
+// --- INIT ---
+// Initialises new data buffer. Capacity is provided in bytes.
+// Returns false on error, otherwise true.
+bool StreamBuffer::init(uint32_t capacity) {
+	if (buffer != 0) {
+		// An existing buffer exists. Erase it first.
+		release();
+	}
+	
+	// Allocate new buffer. Use the mirrored mapping if the capacity allows for it. Allocation 
+	// options need a mapping of their own otherwise.
+	if (capacity == 0) { return false; }
+	allocated = 0;
+	if (!allocateMirrored(capacity) && !allocateMapped(capacity)) {
+		buffer = new uint8_t[capacity];
+		mirrored = false;
+		mapSize = 0;
+	}
+	
+	applyAllocation();
+	
+	this->capacity = capacity;
+	updateHistory();
+	
+	end = buffer + capacity;
+	back = buffer;
+	index = buffer;
+	
+	head = 0;
+	low = 0;
+	tail = 0;
+	tailCache = 0;
+	lowCache = 0;
+	lowFloor = 0;
+	rebasePending = false;
+	generationBase = 0;
+	writerGeneration = generation.load();
+	generationOffset = 0;
+	
+	{
+		std::lock_guard<std::mutex> lk(rangeMutex);
+		ranges.clear();
+		staleRanges.clear();
+		rangeGeneration = generation.load();
+		rangeEnd = 0;
+		rangeOffset = 0;
+	}
+	
+	byteIndex = 0;
+	
+	eof = false;
+	dataRequestPending = false;
+	seekRequestPending = false;
+	state = DBS_IDLE;
+	
+	return true;
+}
+
+
+// --- CLEAN UP ---
+// Clean up resources, delete the buffer.
+bool StreamBuffer::cleanup() {
+	stopRefill();
+	if (buffer != 0) {
+		release();
+	}
+	
+#ifdef PROFILING_DB
+	if (db_debugfile.is_open()) {
+		db_debugfile.flush();
+		db_debugfile.close();
+	}
+#endif
+	
+	return true;
+}
+
+
+// --- ALLOCATE MIRRORED ---
+// Map the same memory pages twice, back to back, so that the region past the buffer end aliases 
+// the start of the buffer. Every span in the buffer is then contiguous in memory.
+// Requires the capacity to be a multiple of the page size.
+// Returns false if the mirrored mapping is not available, otherwise true.
+bool StreamBuffer::allocateMirrored(uint32_t capacity) {
+#ifdef __linux__
+	long pagesize = sysconf(_SC_PAGESIZE);
+	if (pagesize <= 0 || (capacity % pagesize) != 0) { return false; }
+	
+	// Explicit huge pages also need the capacity to be a multiple of the huge page size. Fall 
+	// back to normal pages if the pool can't provide them.
+	if ((allocFlags & DB_ALLOC_HUGETLB) && (capacity % SB_HUGE_PAGE_SIZE) == 0 && 
+																mapMirrored(capacity, true)) {
+		allocated |= DB_ALLOC_HUGETLB;
+		return true;
+	}
+	
+	return mapMirrored(capacity, false);
+#else
+	return false;
+#endif
+}
+
+
+// --- MAP MIRRORED ---
+// Create the mirrored mapping, backed by normal or explicit huge pages.
+// Returns false on error, otherwise true.
+bool StreamBuffer::mapMirrored(uint32_t capacity, bool hugetlb) {
+#ifdef __linux__
+	int fd = memfd_create("streambuffer", MFD_CLOEXEC | (hugetlb ? MFD_HUGETLB : 0));
+	if (fd < 0) { return false; }
+	if (ftruncate(fd, capacity) != 0) {
+		close(fd);
+		return false;
+	}
+	
+	// Reserve the address range for both copies, then map the pages into each half. Huge pages
+	// must be mapped at a huge page boundary: reserve one huge page more, and trim the range 
+	// to an aligned one.
+	size_t mapsize = 2 * (size_t) capacity;
+	size_t slack = hugetlb ? SB_HUGE_PAGE_SIZE : 0;
+	void* base = mmap(0, mapsize + slack, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (base == MAP_FAILED) {
+		close(fd);
+		return false;
+	}
+	
+	uint8_t* low = (uint8_t*) base;
+	if (slack > 0) {
+		uint8_t* aligned = (uint8_t*) (((uintptr_t) low + slack - 1) & ~(uintptr_t) (slack - 1));
+		if (aligned > low) { munmap(low, aligned - low); }
+		if (aligned < low + slack) { munmap(aligned + mapsize, low + slack - aligned); }
+		low = aligned;
+		base = low;
+	}
+	
+	void* lower = mmap(low, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+	void* upper = mmap(low + capacity, capacity, PROT_READ | PROT_WRITE, 
+																MAP_SHARED | MAP_FIXED, fd, 0);
+	close(fd);
+	if (lower == MAP_FAILED || upper == MAP_FAILED) {
+		munmap(base, mapsize);
+		return false;
+	}
+	
+	buffer = low;
+	mirrored = true;
+	mapSize = mapsize;
+	
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+// --- ALLOCATE MAPPED ---
+// Allocate a plain anonymous mapping, for allocation options that can't be applied to memory 
+// obtained with new. Rounded up to whole (huge) pages.
+// Returns false if no options are set or the mapping fails, otherwise true.
+bool StreamBuffer::allocateMapped(uint32_t capacity) {
+#ifdef __linux__
+	if (allocFlags == DB_ALLOC_DEFAULT) { return false; }
+	
+	if (allocFlags & DB_ALLOC_HUGETLB) {
+		size_t mapsize = (capacity + SB_HUGE_PAGE_SIZE - 1) & ~(SB_HUGE_PAGE_SIZE - 1);
+		void* base = mmap(0, mapsize, PROT_READ | PROT_WRITE, 
+											MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (base != MAP_FAILED) {
+			buffer = (uint8_t*) base;
+			mirrored = false;
+			mapSize = mapsize;
+			allocated |= DB_ALLOC_HUGETLB;
+			return true;
+		}
+	}
+	
+	size_t pagesize = sysconf(_SC_PAGESIZE);
+	size_t mapsize = (capacity + pagesize - 1) & ~(pagesize - 1);
+	void* base = mmap(0, mapsize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (base == MAP_FAILED) { return false; }
+	
+	buffer = (uint8_t*) base;
+	mirrored = false;
+	mapSize = mapsize;
+	
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+// --- APPLY ALLOCATION ---
+// Apply the remaining allocation options to the mapped buffer. Each option is applied if the 
+// system allows for it; getAllocation() reports the ones that were.
+void StreamBuffer::applyAllocation() {
+#ifdef __linux__
+	if (mapSize == 0) { return; }
+	
+	// Transparent huge pages. Pointless on explicit huge pages.
+	if ((allocFlags & DB_ALLOC_HUGE_PAGES) && !(allocated & DB_ALLOC_HUGETLB)) {
+		if (madvise(buffer, mapSize, MADV_HUGEPAGE) == 0) { allocated |= DB_ALLOC_HUGE_PAGES; }
+	}
+	
+	// Bind to the NUMA node before the pages are first touched, so that they are placed there.
+	if (allocFlags & DB_ALLOC_NUMA) {
+		unsigned cpu = 0;
+		unsigned node = 0;
+		bool known = true;
+		if (allocNode >= 0) { node = allocNode; }
+		else { known = syscall(SYS_getcpu, &cpu, &node, 0) == 0; }
+		
+		const unsigned long bits = sizeof(unsigned long) * 8;
+		unsigned long nodemask[4] = { 0, 0, 0, 0 };
+		const unsigned long maxnode = 4 * bits;
+		if (known && node < maxnode) {
+			nodemask[node / bits] |= 1UL << (node % bits);
+			if (syscall(SYS_mbind, buffer, mapSize, SB_MPOL_BIND, nodemask, maxnode, 
+																	SB_MPOL_MF_MOVE) == 0) {
+				allocated |= DB_ALLOC_NUMA;
+			}
+		}
+	}
+	
+	// Write to every page, including the mirror, so that the page tables are filled in as well.
+	if (allocFlags & DB_ALLOC_PREFAULT) {
+		size_t step = (allocated & DB_ALLOC_HUGETLB) ? SB_HUGE_PAGE_SIZE : sysconf(_SC_PAGESIZE);
+		volatile uint8_t* page = buffer;
+		for (size_t i = 0; i < mapSize; i += step) { page[i] = 0; }
+		allocated |= DB_ALLOC_PREFAULT;
+	}
+	
+	if (allocFlags & DB_ALLOC_LOCK) {
+		if (mlock(buffer, mapSize) == 0) { allocated |= DB_ALLOC_LOCK; }
+	}
+	
+#ifdef DEBUG
+	std::cout << "StreamBuffer: allocation options " << allocFlags << ", applied " << allocated 
+				<< std::endl;
+#endif
+#endif
+}
+
+
+// --- RELEASE ---
+// Free the memory of the buffer.
+void StreamBuffer::release() {
+#ifdef __linux__
+	if (mapSize > 0) {
+		munmap(buffer, mapSize);
+	}
+	else {
+		delete[] buffer;
+	}
+#else
+	delete[] buffer;
+#endif
+	
+	buffer = 0;
+	mirrored = false;
+	mapSize = 0;
+	allocated = 0;
+}
+
+
+// --- IS MIRRORED ---
+// Returns true if the buffer uses the mirrored mapping, in which case peek() and reserve() 
+// always return a single span.
+bool StreamBuffer::isMirrored() {
+	return mirrored;
+}
+
+
+// --- SET ALLOCATION ---
+// Set the allocation options for the buffer memory, as DataBufferAlloc flags. Takes effect on 
+// the next init(). With DB_ALLOC_NUMA, the pages are bound to 'node', or if it is -1, to the 
+// node of the thread calling init(). Call init() from the consumer thread in that case.
+void StreamBuffer::setAllocation(uint32_t flags, int node) {
+	allocFlags = flags;
+	allocNode = node;
+}
+
+
+// --- GET ALLOCATION ---
+// Returns the allocation options that were applied to the current buffer. Options the system 
+// does not allow for, such as explicit huge pages without a reserved pool or locking beyond 
+// RLIMIT_MEMLOCK, are left out.
+uint32_t StreamBuffer::getAllocation() {
+	return allocated;
+}
+
+
+// --- SET SEEK REQUEST CALLBACK ---
+// The callback is called from the thread that seeks, except when the seek is deferred because 
+// an untagged writer is busy with a request. It is then called from the writer thread, inside 
+// the write or commitWrite() call that delivers the data for that request.
+void StreamBuffer::setSeekRequestCallback(SeekRequestCallback cb) {
+	seekRequestCallback = cb;
+}
+
+
+// --- SET DATA REQUEST CONDITION ---
+void StreamBuffer::setDataRequestCondition(std::condition_variable* condition) {
+	dataRequestCV = condition;
+}
+
+
+// --- SET REQUEST SIZE ---
+// Set the preferred number of bytes to request from the client with each data request.
+// A data request is only started if at least this many bytes are free. Defaults to 200 kB.
+void StreamBuffer::setRequestSize(uint32_t size) {
+	requestSize = size;
+	updateHistory();
+}
+
+
+// --- SET WATERMARKS ---
+// Set the refill thresholds, in unread bytes. The reader starts a data request once the unread 
+// data drops to or below the low watermark. Once a request has been served, the next one is 
+// started right away as long as the unread data is below the high watermark.
+// Both default to the buffer capacity, meaning that requests are started whenever there is 
+// space for a full request.
+void StreamBuffer::setWatermarks(uint32_t low, uint32_t high) {
+	lowWatermark = low;
+	highWatermark = high;
+}
+
+
+// --- GET DATA REQUEST SIZE ---
+// Returns the number of bytes requested by the current data request. This is the preferred
+// request size, limited to the free space in the buffer.
+uint32_t StreamBuffer::getDataRequestSize() {
+	return dataRequestSize;
+}
+
+
+// --- GET DATA REQUEST GENERATION ---
+// Returns the generation of the current data request. Pass it along with the data for the 
+// request, so that data requested before a seek or reset is discarded.
+uint32_t StreamBuffer::getDataRequestGeneration() {
+	return dataRequestGeneration;
+}
+
+
+// --- GET GENERATION ---
+// Returns the current generation, which is bumped on every seek and reset. In the seek request
+// callback this is the generation of the seek.
+uint32_t StreamBuffer::getGeneration() {
+	return generation;
+}
+
+
+// --- SET RANGE REQUESTS ---
+// Set the maximum number of outstanding range requests. With 0, the default, the buffer issues
+// a single data request at a time, which is read with getDataRequestSize(). Otherwise the data 
+// is requested as ranges obtained with nextRange(). Set this before start().
+void StreamBuffer::setRangeRequests(uint32_t count) {
+	std::lock_guard<std::mutex> lk(rangeMutex);
+	maxRanges = count;
+}
+
+
+// --- SET PRODUCER ---
+// Fill the buffer by calling a producer, instead of signalling the data request condition. The
+// producer is called on the executor if one is provided, otherwise on a refill thread owned by
+// the buffer. It is the only writer of the buffer. Pass an empty callback to stop. Set this 
+// before start(). The executor must run every task it is given, stopping waits for them.
+void StreamBuffer::setProducer(ProducerCallback cb, RefillExecutor executor) {
+	stopRefill();
+	producer = cb;
+	refillExecutor = executor;
+	if (!producer) { return; }
+	
+	refillRunning = true;
+	if (!refillExecutor) {
+		refillThread = std::thread(&StreamBuffer::refillLoop, this);
+	}
+}
+
+
+// --- SET RECORD FULL ---
+// Set what record writers do when the buffer has no room for a frame: fail right away, or 
+// wait up to 'timeout' milliseconds for the reader to free space.
+void StreamBuffer::setRecordFull(DataBufferFull mode, uint32_t timeout) {
+	recordFull = mode;
+	recordTimeout = timeout;
+}
+
+
+// --- SET WAIT STRATEGY ---
+// Set the way the reader waits for the writer: condition variable (default), busy-spin for 
+// pinned low-latency cores, spin-then-yield, or futex park. Must not be changed while waiting.
+void StreamBuffer::setWaitStrategy(DataBufferWait strategy) {
+	waiter.setStrategy(strategy);
+	refillWaiter.setStrategy(strategy);
+	spaceWaiter.setStrategy(strategy);
+}
+
+
+// -- SET SESSION HANDLE ---
+void StreamBuffer::setSessionHandle(uint32_t handle) {
+	sessionHandle = handle;
+}
+
+
+// --- GET SESSION HANDLE ---
+uint32_t StreamBuffer::getSessionHandle() {
+	return sessionHandle;
+}
+
+
+// --- SET FILE SIZE ---
+void StreamBuffer::setFileSize(int64_t size) {
+	filesize = size;
+}
+
+
+// --- GET FILE SIZE ---
+int64_t StreamBuffer::getFileSize() {
+	return filesize;
+}
+
+
+// --- START ---
+// Starts calling the data request handler to obtain data.
+bool StreamBuffer::start() {
+	if (dataRequestCV == 0 && !producer) { return false; }
+	
+	triggerDataRequest(freeBytes());
+	
+	return true;
+}
+
+
+// --- REQUEST DATA ---
+void StreamBuffer::requestData() {
+	if (dataRequestCV == 0 && !producer) { return; }
+	
+	// Trigger a data request from the client.
+	triggerDataRequest(freeBytes());
+	
+	// Wait until we have received data or time out.
+	waiter.waitUntil([this] { return !dataRequestPending; }, 
+							std::chrono::steady_clock::now() + std::chrono::microseconds(100));
+}
+
+
+// --- SET HISTORY SIZE ---
+// Set the number of already read bytes to keep in the buffer, so that seeking back into them 
+// does not require a new request to the client. History is kept at the cost of space for new 
+// data, and is limited to leave room for at least one request block. Defaults to 0.
+void StreamBuffer::setHistorySize(uint32_t size) {
+	historySize = size;
+	updateHistory();
+}
+
+
+// --- UPDATE HISTORY ---
+// Determine the amount of history to retain for the current capacity and request size.
+void StreamBuffer::updateHistory() {
+	uint32_t limit = capacity - blockSize();
+	historyRetain = (historySize < limit) ? historySize : limit;
+}
+
+
+// --- REWIND ---
+// Move the read pointer back by 'len' bytes of history.
+void StreamBuffer::rewind(uint32_t len) {
+	index -= len;
+	if (index < buffer) {
+		index += capacity;
+	}
+	
+	byteIndex -= len;
+	head.store(head.load(std::memory_order_relaxed) - len, std::memory_order_relaxed);
+}
+
+
+// --- BLOCK SIZE ---
+// Returns the preferred request size, limited to the buffer capacity.
+uint32_t StreamBuffer::blockSize() {
+	return (requestSize < capacity) ? requestSize : capacity;
+}
+
+
+// --- TRIGGER DATA REQUEST ---
+// Signal the data request handler to write up to one block into the 'locfree' free bytes.
+void StreamBuffer::triggerDataRequest(uint32_t locfree) {
+	if (dataRequestCV == 0 && !producer) { return; }
+	if (maxRanges > 0) {
+		issueRanges();
+		return;
+	}
+	
+	uint32_t block = blockSize();
+	dataRequestSize = (block < locfree) ? block : locfree;
+	dataRequestGeneration = generation.load(std::memory_order_relaxed);
+	dataRequestPending = true;
+	
+	if (!producer) {
+		dataRequestCV->notify_one();
+	}
+	else if (!refillExecutor) {
+		refillWaiter.notify();
+	}
+	else if (refillRunning && !refillQueued.exchange(true)) {
+		// Count the task before checking again that the producer is still called. Paired with 
+		// stopRefill(), either it waits for the task, or the task is not queued.
+		refillTasks.fetch_add(1, std::memory_order_seq_cst);
+		if (!refillRunning) {
+			refillQueued = false;
+			refillTasks.fetch_sub(1, std::memory_order_release);
+			return;
+		}
+		
+		refillExecutor([this] { runRefill(); });
+	}
+}
+
+
+// --- RESET ---
+// Reset the buffer to the initialised state. This leaves the existing allocated buffer intact, 
+// but erases its contents.
+bool StreamBuffer::reset() {
+	cancelSeek();
+	byteIndex = 0;
+	clear();
+	seekRequestPending = false;
+	
+	return true;
+}
+
+
+// --- CLEAR ---
+// Erase the contents of the buffer. This starts a new generation, making the writer discard 
+// data for the previous one. The buffer counters are owned by the writer and the reader 
+// respectively, so the reader skips over the old data once the writer starts on the new 
+// generation, instead of resetting them.
+void StreamBuffer::clear() {
+	generationOffset.store(byteIndex, std::memory_order_relaxed);
+	generation.fetch_add(1, std::memory_order_release);
+	rebasePending = true;
+	tailCache = head.load(std::memory_order_relaxed);	// No cached unread data.
+	
+	eof = false;
+	dataRequestPending = false;
+}
+
+
+// --- REBASE ---
+// Move the reader to the start of the data for the current generation, if the writer has 
+// started on it.
+// Returns false if the writer has not started on the current generation yet, otherwise true.
+bool StreamBuffer::rebase() {
+	if (writerGeneration.load(std::memory_order_acquire) != 
+										generation.load(std::memory_order_relaxed)) {
+		return false;
+	}
+	
+	uint64_t base = generationBase.load(std::memory_order_relaxed);
+	index = buffer + (base % capacity);
+	head.store(base, std::memory_order_relaxed);
+	low.store(base, std::memory_order_release);
+	tailCache = base;
+	rebasePending = false;
+	
+	return true;
+}
+
+
+// --- SEEK ---
+// Seek to a specific point in the data, waiting up to a second for the seek to complete.
+// Returns the new absolute byte position in the file, or -1 in case of failure.
+int64_t StreamBuffer::seek(DataBufferSeek mode, int64_t offset) {
+	std::shared_future<int64_t> result = seekAsync(mode, offset);
+	
+	// Wait for response.
+	if (!waiter.waitUntil([&result] { 
+				return result.wait_for(std::chrono::seconds(0)) == std::future_status::ready; 
+			}, std::chrono::steady_clock::now() + std::chrono::seconds(1))) {
+#ifdef DEBUG
+		std::cout << "Time-out on seek request. Returning -1." << std::endl;
+#endif
+		cancelSeek();
+		return -1;
+	}
+	
+	return result.get();
+}
+
+
+// --- SEEK ASYNC ---
+// Start a seek to a specific point in the data, without waiting for it to complete.
+// Seeks within the data in the buffer complete right away. Otherwise the buffer is cleared, and 
+// the seek completes when the writer has written the first data at the new offset. Until then 
+// reads return no data. A new seek cancels a pending one.
+// Returns a future for the new absolute byte position in the file, which is -1 in case of 
+// failure or cancellation.
+std::shared_future<int64_t> StreamBuffer::seekAsync(DataBufferSeek mode, int64_t offset) {
+#ifdef DEBUG
+	std::cout << "StreamBuffer::seekAsync: mode " << mode << ", offset: " << offset << std::endl;
+#endif
+	
+	std::promise<int64_t> done;
+	std::shared_future<int64_t> result = done.get_future().share();
+	
+	// Calculate absolute byte index. While a seek is pending, offsets are relative to its target.
+	bool pending = (state == DBS_SEEKING) || rebasePending;
+	int64_t position = (state == DBS_SEEKING) ? seekTarget : byteIndex;
+	int64_t new_offset = -1;
+	if 		(mode == DB_SEEK_START)		{ new_offset = offset; }
+	else if (mode == DB_SEEK_CURRENT) 	{ new_offset = position + offset; }
+	else if (mode == DB_SEEK_END)		{ new_offset = filesize - offset - 1; }
+	
+#ifdef DEBUG
+	std::cout << "New offset: " << new_offset << std::endl;
+	std::cout << "ByteIndex: " << byteIndex << std::endl;
+#endif
+
+	// Ensure that the new offset isn't past the beginning/end of the file. If so, return -1.
+	if (new_offset < 0 || new_offset > filesize) {
+#ifdef DEBUG
+		std::cout << "New offset larger than file size or negative. Returning -1." << std::endl;
+#endif
+		done.set_value(-1);
+		return result;
+	}
+	
+	if (!pending) {
+		// If the new offset is still in the history section of the buffer, move the read 
+		// pointer back to it.
+		uint32_t history = head.load(std::memory_order_relaxed) - 
+												low.load(std::memory_order_relaxed);
+		int64_t byteIndexLow = byteIndex - history;
+		if (new_offset >= byteIndexLow && new_offset <= byteIndex) {
+#ifdef DEBUG
+			std::cout << "Seeking back in history." << std::endl;
+#endif
+			rewind(byteIndex - new_offset);
+			done.set_value(new_offset);
+			return result;
+		}
+		
+		// If the new offset is in the unread section of the buffer, skip ahead to it.
+		int64_t byteIndexHigh = byteIndex + readable();
+		if (new_offset > byteIndex && new_offset <= byteIndexHigh) {
+#ifdef DEBUG
+			std::cout << "Skipping ahead in unread data." << std::endl;
+#endif
+			skip(new_offset - byteIndex);
+			done.set_value(new_offset);
+			return result;
+		}
+	}
+	
+	if (seekRequestCallback == 0 && !producer) { 
+		done.set_value(-1);
+		return result;
+	}
+	
+	// Replace any pending seek. Data a tagged writer is still writing for a data request or the 
+	// previous seek is tagged with an old generation and gets discarded, so there is no need 
+	// to wait for it. The new generation is started before the seek state is published, so 
+	// that such data cannot complete the seek. 
+	// Untagged data can't be told apart from data for the new offset. If an untagged writer is
+	// busy with a request, the seek is requested once that data lands, and the data discarded.
+	bool deferred;
+	{
+		std::lock_guard<std::mutex> lk(seekMutex);
+		if (seekPending) { seekPromise.set_value(-1); }
+		seekPromise = std::move(done);
+		seekPending = true;
+		seekTarget = new_offset;
+		deferred = !taggedWrites && maxRanges == 0 && !producer && 
+										(dataRequestPending || seekRequestPending || seekDeferred);
+		if (deferred && !seekDeferred) {
+			seekOrigin = generationOffset.load(std::memory_order_relaxed);
+			seekOriginGeneration = generation.load(std::memory_order_relaxed);
+		}
+		
+		seekDeferred = deferred;
+		startSeek(new_offset);
+		state = DBS_SEEKING;
+	}
+	
+	if (!deferred) {
+		requestSeek(new_offset);
+	}
+#ifdef DEBUG
+	else {
+		std::cout << "Seek deferred until the pending request completes." << std::endl;
+	}
+#endif
+	
+	return result;
+}
+
+
+// --- START SEEK ---
+// Clear the buffer for the new offset, starting the generation of the seek. Must be called 
+// with the seek mutex held.
+void StreamBuffer::startSeek(int64_t offset) {
+#ifdef DEBUG
+	std::cout << "Proceeding with reset." << std::endl;
+#endif
+	
+	// We assume the local data isn't in the buffer and reload.
+	byteIndex = offset;
+	clear();
+	seekGeneration = generation.load(std::memory_order_relaxed);
+	seekRequestPending = true;
+}
+
+
+// --- REQUEST SEEK ---
+// Request the data at the new offset from the client.
+void StreamBuffer::requestSeek(int64_t offset) {
+	if (seekRequestCallback) { seekRequestCallback(sessionHandle, offset); }
+	
+	// In range request mode the data at the new offset is requested as ranges as well. A 
+	// producer is asked for it directly. The whole buffer is free for the new position.
+	if (maxRanges > 0 || producer) { triggerDataRequest(capacity); }
+}
+
+
+// --- CANCEL SEEK ---
+// Cancel a pending seek, completing it with -1.
+void StreamBuffer::cancelSeek() {
+	std::lock_guard<std::mutex> lk(seekMutex);
+	if (!seekPending) { return; }
+	
+	seekPromise.set_value(-1);
+	seekPending = false;
+	seekRequestPending = false;
+	state = DBS_IDLE;
+	
+	if (seekDeferred) {
+		seekDeferred = false;
+		restoreSeekOrigin();
+	}
+}
+
+
+// --- RESTORE SEEK ORIGIN ---
+// A deferred seek never got requested, so the untagged writer still answers the request it was
+// busy with, and that data continues the stream where the generation the seek left ended. Start
+// a new generation at that position, so the data is not taken for data at the seek target. 
+// Must be called with the seek mutex held.
+void StreamBuffer::restoreSeekOrigin() {
+	// The writer publishes nothing while the seek is deferred, so its tail is stable. If it
+	// had not started on the origin generation yet, its next data starts that generation.
+	int64_t position = seekOrigin;
+	if (writerGeneration.load(std::memory_order_acquire) == seekOriginGeneration) {
+		position += tail.load(std::memory_order_acquire) - 
+										generationBase.load(std::memory_order_relaxed);
+	}
+	
+#ifdef DEBUG
+	std::cout << "Deferred seek cancelled, restoring position " << position << std::endl;
+#endif
+	byteIndex = position;
+	clear();
+	dataRequestPending = true;	// The writer is still busy with it.
+}
+
+
+// --- START DEFERRED SEEK ---
+// Called by the writer with data while a seek is deferred. The data answers the request that 
+// was pending when the seek started, so it is for the old position. It is discarded, and the
+// seek is requested.
+// Returns false if no seek is deferred, otherwise true.
+bool StreamBuffer::startDeferredSeek() {
+	int64_t target;
+	{
+		std::lock_guard<std::mutex> lk(seekMutex);
+		if (!seekDeferred) { return false; }
+		
+		seekDeferred = false;
+		target = seekTarget;
+	}
+	
+#ifdef DEBUG
+	std::cout << "Discarding data for old position, starting deferred seek." << std::endl;
+#endif
+	requestSeek(target);
+	
+	return true;
+}
+
+
+// --- COMPLETE SEEK ---
+// Called by the writer with the first data at the new offset, published for generation 'gen'.
+// Returns false if that data is not for the pending seek, otherwise true.
+bool StreamBuffer::completeSeek(uint32_t gen) {
+	std::lock_guard<std::mutex> lk(seekMutex);
+	if (state != DBS_SEEKING || seekDeferred || gen != seekGeneration) { return false; }
+	
+	if (seekPending) { seekPromise.set_value(seekTarget); }
+	seekPending = false;
+	seekRequestPending = false;
+	dataRequestPending = false;
+	state = DBS_IDLE;
+	
+	return true;
+}
+
+
+// --- TELL ---
+// Returns the position in the streamed data of the first unread byte.
+int64_t StreamBuffer::tell() {
+	return byteIndex;
+}
+
+
+// --- SEEKING ---
+bool StreamBuffer::seeking() {
+	return (state == DBS_SEEKING);
+}
+
+
+// --- READ ---
+// Try to read 'len' bytes from the buffer, into the provided buffer.
+// Returns the number of bytes read, or 0 in case of an error.
+uint32_t StreamBuffer::read(uint32_t len, uint8_t* bytes) {
+#ifdef DEBUG
+	std::cout << "StreamBuffer::read: len " << len << ". EOF: " << eof << std::endl;
+#endif
+
+	// Request more data if the buffer does not have enough unread data left, and EOF condition
+	// has not been reached.
+	if (!eof && len > readable()) {
+		// More data should be available on the client, try to request it.
+#ifdef DEBUG
+		std::cout << "Requesting more data..." << std::endl;
+#endif
+		requestData();
+	}
+	
+	uint32_t bytesRead = copyOut(len, bytes);
+	
+#ifdef DEBUG
+	if (bytesRead == 0) {
+		if (eof) 	{ std::cout << "Reached EOF." << std::endl; }
+		else 		{ std::cout << "Read failed due to empty buffer." << std::endl; }
+	}
+	
+	std::cout << "head " << head << ", tail " << tailCache << std::endl;
+	std::cout << "bytesRead: " << bytesRead << std::endl;
+#endif
+	
+	return bytesRead;
+}
+
+
+// --- READ V ---
+// Scatter read: fill the segments in order from the unread data, with a single commit. 
+// Requests more data like read() if the segments are not all filled.
+// Returns the number of bytes read.
+uint32_t StreamBuffer::readv(const BufferSpan* segments, uint32_t count) {
+	uint32_t len = segmentsLength(segments, count);
+	if (!eof && len > readable()) { requestData(); }
+	
+	BufferSpan first, second;
+	if (peek(first, second) == 0) { return 0; }
+	
+	return commit(copySegments(first, second, segments, count, false));
+}
+
+
+// --- READ AT LEAST ---
+// Read between 'min' and 'len' bytes into the provided buffer, waiting for the writer until at 
+// least 'min' bytes have been read, EOF is reached or the deadline passes. Data is copied as it 
+// arrives, so 'min' may exceed the capacity of the buffer.
+// Returns the number of bytes read, which is less than 'min' on EOF or time-out.
+uint32_t StreamBuffer::readAtLeast(uint32_t min, uint32_t len, uint8_t* bytes, 
+										std::chrono::steady_clock::time_point deadline) {
+	if (min > len) { min = len; }
+	uint32_t bytesRead = copyOut(len, bytes);
+	while (bytesRead < min) {
+		if (!waitForData(1, deadline)) { break; }
+		
+		uint32_t chunk = copyOut(len - bytesRead, bytes + bytesRead);
+		if (chunk == 0 && eof) { break; }
+		bytesRead += chunk;
+	}
+	
+	return bytesRead;
+}
+
+
+// --- READ EXACT ---
+// Wait until 'len' bytes are available, then read them into the provided buffer. Nothing is 
+// read if EOF is reached with fewer bytes left or the deadline passes. 'len' must fit in the 
+// buffer next to the history.
+// Returns 'len', or 0 on EOF or time-out.
+uint32_t StreamBuffer::readExact(uint32_t len, uint8_t* bytes, 
+										std::chrono::steady_clock::time_point deadline) {
+	if (len > capacity - historyRetain) { return 0; }
+	if (!waitForData(len, deadline) || readable() < len) { return 0; }
+	
+	return copyOut(len, bytes);
+}
+
+
+// --- READ TO EOF ---
+// Read into the provided buffer until EOF is reached and all data has been read, 'len' bytes
+// have been read or the deadline passes.
+// Returns the number of bytes read.
+uint32_t StreamBuffer::readToEof(uint32_t len, uint8_t* bytes, 
+										std::chrono::steady_clock::time_point deadline) {
+	return readAtLeast(len, len, bytes, deadline);
+}
+
+
+// --- COPY OUT ---
+// Copy up to 'len' unread bytes into the provided buffer and commit them.
+// Returns the number of bytes copied.
+uint32_t StreamBuffer::copyOut(uint32_t len, uint8_t* bytes) {
+	// Obtain the unread section. The second span is only used if the unread section wraps 
+	// around the end of the buffer.
+	BufferSpan first, second;
+	if (peek(first, second) == 0) { return 0; }
+	
+	// Read from the back of the buffer first, then read the rest from the front.
+	uint32_t bytesRead = (len < first.length) ? len : first.length;
+	memcpy(bytes, first.data, bytesRead);
+	if (bytesRead < len && second.length > 0) {
+		uint32_t bytesToRead = len - bytesRead;
+		if (bytesToRead > second.length) { bytesToRead = second.length; }
+		
+#ifdef DEBUG
+		std::cout << "Read back, then front. bytesToRead: " << bytesToRead << std::endl;
+#endif
+		memcpy(bytes + bytesRead, second.data, bytesToRead);
+		bytesRead += bytesToRead;
+	}
+	
+	commit(bytesRead);
+	
+	return bytesRead;
+}
+
+
+// --- WAIT FOR DATA ---
+// Wait until at least 'min' bytes are unread, EOF is reached or the deadline passes. A data 
+// request is started if none is pending. The writer wakes us up when it commits data.
+// Returns false on time-out, otherwise true.
+bool StreamBuffer::waitForData(uint32_t min, std::chrono::steady_clock::time_point deadline) {
+	return waiter.waitUntil([this, min] {
+		if (readable() >= min || eof) { return true; }
+		if (!dataRequestPending) { triggerDataRequest(freeBytes()); }
+		return false;
+	}, deadline);
+}
+
+
+// --- READABLE ---
+// Refresh the reader's copy of the tail.
+// Returns the number of unread bytes.
+uint32_t StreamBuffer::readable() {
+	if (rebasePending && !rebase()) { return 0; }
+	tailCache = tail.load(std::memory_order_acquire);
+	return tailCache - head.load(std::memory_order_relaxed);
+}
+
+
+// --- WRITABLE ---
+// Refresh the writer's copy of the low counter. Both unread and history bytes are kept.
+// Returns the number of free bytes.
+uint32_t StreamBuffer::writable() {
+	lowCache = low.load(std::memory_order_acquire);
+	if (lowCache < lowFloor) { lowCache = lowFloor; }
+	return capacity - (tail.load(std::memory_order_relaxed) - lowCache);
+}
+
+
+// --- FREE BYTES ---
+// Returns the number of free bytes, without using the cached counters of either side.
+uint32_t StreamBuffer::freeBytes() {
+	return capacity - (tail.load(std::memory_order_acquire) - low.load(std::memory_order_acquire));
+}
+
+
+// --- PEEK ---
+// Obtain the unread section of the buffer without copying it. The first span starts at the read
+// pointer, the second span covers the part that wrapped around to the front of the buffer, and 
+// is empty if there is no wrap or the buffer is mirrored. The spans stay valid until the next 
+// commit() call.
+// Returns the total number of unread bytes in both spans.
+uint32_t StreamBuffer::peek(BufferSpan &first, BufferSpan &second) {
+	uint32_t locunread = readable();
+	uint32_t bytesSingleRead = locunread;
+	if (!mirrored && (end - index) < bytesSingleRead) { 
+		bytesSingleRead = end - index; // Unread section wraps around.
+	}
+	
+	first.data = index;
+	first.length = bytesSingleRead;
+	second.data = buffer;
+	second.length = locunread - bytesSingleRead;
+	
+	return locunread;
+}
+
+
+// --- COMMIT ---
+// Mark 'len' bytes obtained with peek() as read, making them free for overwriting.
+// Returns the number of bytes committed, which is limited to the number of unread bytes.
+uint32_t StreamBuffer::commit(uint32_t len) {
+	// Use the cached tail if it covers the committed bytes, otherwise refresh it.
+	uint64_t lochead = head.load(std::memory_order_relaxed);
+	uint32_t locunread = tailCache - lochead;
+	if (len > locunread) { locunread = readable(); }
+	if (len > locunread) { len = locunread; }
+	
+	index += len;		// Advance read pointer.
+	if (index >= end) {
+		index -= capacity;	// Read pointer went past the buffer end. Wrap to buffer begin.
+	}
+	
+	byteIndex += len;
+	lochead += len;
+	head.store(lochead, std::memory_order_relaxed);
+	
+	// Publish the read bytes that fall out of the history as free for overwriting. The release 
+	// ordering ensures that we are done reading them before the writer can see this.
+	uint64_t loclow = low.load(std::memory_order_relaxed);
+	if (lochead - loclow > historyRetain) {
+		loclow = lochead - historyRetain;
+		low.store(loclow, std::memory_order_release);
+	}
+	
+	// Trigger a data request from the client if we dropped to the low watermark and have space 
+	// for another block.
+	locunread -= len;
+	uint32_t locfree = capacity - (tailCache - loclow);
+	if (eof) {
+		// Do nothing.
+	}
+	else if (!dataRequestPending && locunread <= lowWatermark && locfree >= blockSize()) {
+		triggerDataRequest(locfree);
+	}
+	
+	// Wake up record writers waiting for space.
+	if (recordFull == DB_FULL_BLOCK) { spaceWaiter.notify(); }
+	
+	return len;
+}
+
+
+// --- SKIP ---
+// Skip over 'len' unread bytes without copying them.
+// Returns the number of bytes skipped, which is limited to the number of unread bytes.
+uint32_t StreamBuffer::skip(uint32_t len) {
+	return commit(len);
+}
+
+
+// --- DRAIN ---
+// Write up to 'max' unread bytes to a file descriptor, such as a socket or pipe, straight from 
+// the buffer with a single sendmsg() or writev() call over the unread spans. Only the bytes the
+// kernel accepted are committed. With a non-blocking descriptor this may be fewer than requested.
+// Sockets are written with MSG_NOSIGNAL, so a closed peer fails with EPIPE instead of raising 
+// SIGPIPE. Other descriptors, such as pipes, still raise it. Whether the descriptor is a socket
+// is looked up once, and again when drain() is called with a different descriptor.
+// vmsplice() is not used: the pipe would keep referencing the buffer pages after the commit, 
+// while the writer may already be overwriting them.
+// Returns the number of bytes written, or -1 on error, with errno set (e.g. EAGAIN).
+int64_t StreamBuffer::drain(int fd, uint32_t max) {
+#ifdef __linux__
+	BufferSpan first, second;
+	uint32_t locunread = peek(first, second);
+	if (locunread == 0) { return 0; }
+	if (max < first.length) { first.length = max; }
+	if (max - first.length < second.length) { second.length = max - first.length; }
+	
+	struct iovec iov[2];
+	iov[0].iov_base = first.data;
+	iov[0].iov_len = first.length;
+	iov[1].iov_base = second.data;
+	iov[1].iov_len = second.length;
+	
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = (second.length > 0) ? 2 : 1;
+	
+	if (fd != drainFd) {
+		struct stat st;
+		drainSocket = (fstat(fd, &st) == 0) && S_ISSOCK(st.st_mode);
+		drainFd = fd;
+	}
+	
+	ssize_t res = -1;
+	if (drainSocket) {
+		do {
+			res = sendmsg(fd, &msg, MSG_NOSIGNAL);
+		} while (res < 0 && errno == EINTR);
+		
+		// The descriptor was closed and its number reused for a file.
+		if (res < 0 && errno == ENOTSOCK) { drainSocket = false; }
+	}
+	
+	if (!drainSocket) {
+		do {
+			res = ::writev(fd, iov, msg.msg_iovlen);
+		} while (res < 0 && errno == EINTR);
+	}
+	
+	if (res < 0) {
+#ifdef DEBUG
+		std::cout << "StreamBuffer::drain: write failed, errno " << errno << std::endl;
+#endif
+		return -1;
+	}
+	
+	return commit((uint32_t) res);
+#else
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+
+// --- WRITE ---
+// Write data into the buffer.
+uint32_t StreamBuffer::write(std::string &data) {
+	return write(data.data(), data.length());
+}
+
+
+uint32_t StreamBuffer::write(const char* data, uint32_t length) {
+#ifdef DEBUG
+	std::cout << "StreamBuffer::write: len " << length << std::endl;
+	std::cout << "Index: " << index - buffer << ", Back: " << back - buffer << std::endl;
+#endif
+
+	// Obtain the free section. If it wraps around the end of the buffer, we write to the back 
+	// first, then write the remainder into the front of the buffer.
+	BufferSpan first, second;
+	reserve(length, first, second);
+	
+	uint32_t bytesWritten = first.length;
+	memcpy(first.data, data, bytesWritten);
+	if (second.length > 0) {
+#ifdef DEBUG
+		std::cout << "Partial write at back, rest at front. Single write: " << bytesWritten << std::endl;
+#endif
+		memcpy(second.data, data + bytesWritten, second.length);
+		bytesWritten += second.length;
+	}
+	
+	return commitWrite(bytesWritten);
+}
+
+
+// --- WRITE ---
+// Like write(), for data obtained for the given generation. If the reader has seeked or reset 
+// since, the data is discarded.
+// Returns the number of bytes written, or 0 if the data was discarded.
+uint32_t StreamBuffer::write(const char* data, uint32_t length, uint32_t gen) {
+	taggedWrites = true;
+	if (!adoptGeneration(gen)) { return 0; }
+	
+	BufferSpan first, second;
+	reserve(length, first, second);
+	
+	uint32_t bytesWritten = first.length;
+	memcpy(first.data, data, bytesWritten);
+	if (second.length > 0) {
+		memcpy(second.data, data + bytesWritten, second.length);
+		bytesWritten += second.length;
+	}
+	
+	return commitWrite(bytesWritten, gen);
+}
+
+
+// --- WRITE V ---
+// Gather write: copy the segments into the buffer in order, and publish them with a single 
+// commitWrite(), so one tail update and one reader notification for the whole batch. Segments 
+// that don't fit are written partially or not at all.
+// Returns the number of bytes written.
+uint32_t StreamBuffer::writev(const BufferSpan* segments, uint32_t count) {
+	BufferSpan first, second;
+	reserve(segmentsLength(segments, count), first, second);
+	
+	return commitWrite(copySegments(first, second, segments, count, true));
+}
+
+
+// --- WRITE V ---
+// Like writev(), for data obtained for the given generation.
+// Returns the number of bytes written, or 0 if the data was discarded.
+uint32_t StreamBuffer::writev(const BufferSpan* segments, uint32_t count, uint32_t gen) {
+	BufferSpan first, second;
+	if (reserve(segmentsLength(segments, count), first, second, gen) == 0) { return 0; }
+	
+	return commitWrite(copySegments(first, second, segments, count, true), gen);
+}
+
+
+// --- RESERVE ---
+// Obtain up to 'max' bytes of free space in the buffer to write into directly. The first span 
+// starts at the write pointer, the second span covers the part that wraps around to the front 
+// of the buffer, and is empty if there is no wrap. Data written into the spans becomes visible
+// to the reader once it is published with commitWrite(). With a mirrored buffer the second
+// span is always empty.
+// Returns the total number of bytes in both spans.
+uint32_t StreamBuffer::reserve(uint32_t max, BufferSpan &first, BufferSpan &second) {
+	// Determine the number of bytes we can write in one copy operation.
+	// This depends on the number of 'free' bytes, and the location of the read pointer ('index') 
+	// compared to the  write pointer ('back'). If the read pointer is ahead of the write pointer, 
+	// we can write up till there, otherwise to the end of the buffer.
+	// Use the cached low counter if it shows enough free space, otherwise refresh it.
+	uint32_t locfree = capacity - (tail.load(std::memory_order_relaxed) - lowCache);
+	if (locfree < max) { locfree = writable(); }
+	if (max < locfree) { locfree = max; }
+	uint32_t bytesSingleWrite = locfree;
+	if (!mirrored && (end - back) < bytesSingleWrite) { bytesSingleWrite = end - back; }
+	
+	first.data = back;
+	first.length = bytesSingleWrite;
+	second.data = buffer;
+	second.length = locfree - bytesSingleWrite;
+	
+	return locfree;
+}
+
+
+// --- RESERVE ---
+// Like reserve(), for data obtained for the given generation. Any data of older generations 
+// may be overwritten.
+// Returns the total number of bytes in both spans, or 0 if the generation is out of date.
+uint32_t StreamBuffer::reserve(uint32_t max, BufferSpan &first, BufferSpan &second, 
+																			uint32_t gen) {
+	taggedWrites = true;
+	if (!adoptGeneration(gen)) {
+		first.data = back;
+		first.length = 0;
+		second.data = buffer;
+		second.length = 0;
+		return 0;
+	}
+	
+	return reserve(max, first, second);
+}
+
+
+// --- ADOPT GENERATION ---
+// Start writing data for the given generation. Data of the previous generation is dropped: 
+// the reader skips over it once it sees the new generation, so the writer can overwrite it
+// without waiting for the reader.
+// Returns false if the generation is out of date, in which case the data should be discarded.
+bool StreamBuffer::adoptGeneration(uint32_t gen) {
+	if (gen != generation.load(std::memory_order_acquire)) {
+#ifdef DEBUG
+		std::cout << "Discarding data for generation " << gen << std::endl;
+#endif
+		dataRequestPending = false;
+		return false;
+	}
+	
+	if (writerGeneration.load(std::memory_order_relaxed) == gen) { return true; }
+	
+	// The new generation starts at the current tail. Publish the base before the generation,
+	// so that the reader sees the right base once it sees the generation.
+	uint64_t loctail = tail.load(std::memory_order_relaxed);
+	generationBase.store(loctail, std::memory_order_relaxed);
+	lowFloor = loctail;
+	if (lowCache < lowFloor) { lowCache = lowFloor; }
+	writerGeneration.store(gen, std::memory_order_release);
+	
+	return true;
+}
+
+
+// --- COMMIT WRITE ---
+// Publish 'length' bytes written into the spans obtained with reserve() to the reader.
+// If a seek was deferred until this data landed, the data is discarded instead.
+// Returns the number of bytes committed, which is limited to the number of free bytes.
+uint32_t StreamBuffer::commitWrite(uint32_t length) {
+	return publishWrite(length, generation.load(std::memory_order_acquire));
+}
+
+
+// --- COMMIT WRITE ---
+// Publish 'length' bytes written into reserved space, for data obtained for the given 
+// generation. If the reader has seeked or reset since, the data is discarded.
+// Returns the number of bytes published, or 0 if the data was discarded.
+uint32_t StreamBuffer::commitWrite(uint32_t length, uint32_t gen) {
+	taggedWrites = true;
+	return publishWrite(length, gen);
+}
+
+
+// --- PUBLISH WRITE ---
+// Publish 'length' bytes of reserved space for generation 'gen'. Tagged and untagged commits 
+// both end up here.
+// Returns the number of bytes published, or 0 if the data was discarded.
+uint32_t StreamBuffer::publishWrite(uint32_t length, uint32_t gen) {
+	if (seekDeferred && startDeferredSeek()) { return 0; }
+	if (!adoptGeneration(gen)) { return 0; }
+	
+	uint32_t locfree = capacity - (tail.load(std::memory_order_relaxed) - lowCache);
+	if (length > locfree) { locfree = writable(); }
+	if (length > locfree) { length = locfree; }
+	
+	back += length;
+	if (back >= end) {
+		back -= capacity;
+	}
+	
+	// Publish the written bytes. The release ordering makes the data visible to the reader 
+	// before the new tail is.
+	uint64_t loctail = tail.load(std::memory_order_relaxed) + length;
+	tail.store(loctail, std::memory_order_release);
+	locfree -= length;
+	
+#ifdef DEBUG
+		std::cout << "low: " << lowCache << ", tail: " 
+					<< loctail << ", bytesWritten: " << length << std::endl;
+#endif
+	
+	// If this is the first data for a pending seek, signal that we're done.
+	if (state == DBS_SEEKING && completeSeek(gen)) {
+#ifdef DEBUG
+		std::cout << "In seeking mode. Notifying seeking routine." << std::endl;
+#endif
+		waiter.notify();
+		
+		return length;
+	}
+	
+#ifdef DEBUG
+		std::cout << "Data request done." << std::endl;
+#endif
+	
+	dataRequestPending = false;
+	waiter.notify();
+	
+	// Trigger a data request from the client if we are below the high watermark and have space 
+	// for another block. Only refresh the low counter if the cached value does not show enough 
+	// space.
+	uint32_t block = blockSize();
+	if (!eof && locfree < block) { locfree = writable(); }
+	if (eof) {
+		// Do nothing.
+	}
+	else if ((uint32_t) (loctail - head.load(std::memory_order_relaxed)) < highWatermark && 
+																		locfree >= block) {
+#ifdef DEBUG
+		std::cout << "Data request started." << std::endl;
+#endif
+		triggerDataRequest(locfree);
+	}
+	
+	return length;
+}
+
+
+// --- SYNC RANGES ---
+// Start on the ranges for a new generation, after a seek or reset. Must be called with the 
+// range mutex held.
+void StreamBuffer::syncRanges() {
+	uint32_t gen = generation.load(std::memory_order_acquire);
+	if (gen == rangeGeneration) { return; }
+	
+	// Slots handed out for the old generation stay reserved until the client completes them, 
+	// as it may still be writing into them.
+	for (RangeSlot &slot : ranges) {
+		if (slot.assigned && !slot.done) { staleRanges.push_back(slot); }
+	}
+	
+	ranges.clear();
+	
+	// The new generation starts past all reserved slots. Publish the base before the generation,
+	// like adoptGeneration().
+	uint64_t base = rangeEnd;
+	back = buffer + (base % capacity);
+	tail.store(base, std::memory_order_relaxed);
+	generationBase.store(base, std::memory_order_relaxed);
+	lowFloor = base;
+	if (lowCache < lowFloor) { lowCache = lowFloor; }
+	rangeOffset = generationOffset.load(std::memory_order_relaxed);
+	rangeGeneration = gen;
+	writerGeneration.store(gen, std::memory_order_release);
+	
+#ifdef DEBUG
+	std::cout << "Ranges for generation " << gen << " start at offset " << rangeOffset 
+				<< ", tail: " << base << std::endl;
+#endif
+}
+
+
+// --- FILL RANGES ---
+// Reserve slots for new ranges until the maximum number of ranges is outstanding or the buffer 
+// is full, then wake up the client. Must be called with the range mutex held.
+void StreamBuffer::fillRanges() {
+	syncRanges();
+	
+	// The oldest byte still in use is kept by the reader as history, or is in a stale slot.
+	uint64_t floor = low.load(std::memory_order_acquire);
+	if (floor < lowFloor) { floor = lowFloor; }
+	for (RangeSlot &slot : staleRanges) {
+		if (slot.start < floor) { floor = slot.start; }
+	}
+	
+	uint32_t outstanding = 0;
+	for (RangeSlot &slot : ranges) {
+		if (!slot.done) { outstanding++; }
+	}
+	
+	uint32_t block = blockSize();
+	uint32_t issued = 0;
+	while (!eof && outstanding < maxRanges) {
+		// Only request less than a block if nothing is outstanding.
+		uint32_t locfree = capacity - (rangeEnd - floor);
+		uint32_t length = (block < locfree) ? block : locfree;
+		if (length == 0 || (length < block && outstanding > 0)) { break; }
+		if (filesize > 0) {
+			if (rangeOffset >= filesize) { break; }
+			if (filesize - rangeOffset < length) { length = filesize - rangeOffset; }
+		}
+		
+		RangeSlot slot;
+		slot.request.id = nextRangeId++;
+		slot.request.offset = rangeOffset;
+		slot.request.length = length;
+		slot.request.generation = rangeGeneration;
+		slot.start = rangeEnd;
+		slot.filled = 0;
+		slot.assigned = false;
+		slot.done = false;
+		ranges.push_back(slot);
+		
+		rangeEnd += length;
+		rangeOffset += length;
+		dataRequestSize = length;
+		outstanding++;
+		issued++;
+	}
+	
+	dataRequestGeneration = rangeGeneration;
+	dataRequestPending = (outstanding > 0);
+	
+#ifdef DEBUG
+	std::cout << "Issued " << issued << " ranges, outstanding: " << outstanding << std::endl;
+#endif
+	
+	if (issued > 0) {
+		if (dataRequestCV != 0) { dataRequestCV->notify_all(); }
+		rangeWaiter.notify();
+	}
+}
+
+
+// --- ISSUE RANGES ---
+void StreamBuffer::issueRanges() {
+	std::lock_guard<std::mutex> lk(rangeMutex);
+	fillRanges();
+}
+
+
+// --- NEXT RANGE ---
+// Obtain the next range to fetch, in range request mode. Each range obtained must be completed
+// with completeRange(), also if fetching it failed.
+// Returns false if no range is waiting to be fetched, otherwise true.
+bool StreamBuffer::nextRange(RangeRequest &request) {
+	std::lock_guard<std::mutex> lk(rangeMutex);
+	syncRanges();
+	for (RangeSlot &slot : ranges) {
+		if (!slot.assigned) {
+			slot.assigned = true;
+			request = slot.request;
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+
+// --- NEXT RANGE ---
+// Like nextRange(), waiting until the deadline for a range to be issued. The wait is woken up 
+// when ranges are issued, so fetchers don't have to poll for them.
+// Returns false if no range was issued before the deadline, otherwise true.
+bool StreamBuffer::nextRange(RangeRequest &request, std::chrono::steady_clock::time_point deadline) {
+	return rangeWaiter.waitUntil([this, &request] { return nextRange(request); }, deadline);
+}
+
+
+// --- RESERVE RANGE ---
+// Obtain the slot of the buffer reserved for a range, to write its data into directly. The 
+// second span covers the part that wraps around to the front of the buffer, like reserve().
+// Returns the size of the slot, or 0 if the range is out of date and its data is discarded.
+uint32_t StreamBuffer::reserveRange(const RangeRequest &request, BufferSpan &first, 
+																		BufferSpan &second) {
+	std::lock_guard<std::mutex> lk(rangeMutex);
+	first.data = buffer;
+	first.length = 0;
+	second.data = buffer;
+	second.length = 0;
+	
+	syncRanges();
+	for (RangeSlot &slot : ranges) {
+		if (slot.request.id != request.id) { continue; }
+		if (slot.done) { return 0; }
+		
+		uint8_t* start = buffer + (slot.start % capacity);
+		uint32_t bytesSingleWrite = slot.request.length;
+		if (!mirrored && (end - start) < bytesSingleWrite) { bytesSingleWrite = end - start; }
+		
+		first.data = start;
+		first.length = bytesSingleWrite;
+		second.length = slot.request.length - bytesSingleWrite;
+		return slot.request.length;
+	}
+	
+	return 0;
+}
+
+
+// --- COMPLETE RANGE ---
+// Mark the data of a range as written into its slot. Ranges are published to the reader in 
+// offset order, so a range that completes early waits for the ranges before it. If fewer bytes
+// than requested are delivered the rest is requested again as a new range, unless EOF is set 
+// or 'end' is set. With 'end' the data ends with this range, e.g. on a short read or an error:
+// EOF is set once the range is published. Otherwise EOF is set once the published ranges 
+// reach the file size.
+// Returns the number of bytes accepted, or 0 if the range is out of date and was discarded.
+uint32_t StreamBuffer::completeRange(const RangeRequest &request, uint32_t length, bool end) {
+	std::lock_guard<std::mutex> lk(rangeMutex);
+	
+	// A seek or reset since the range was handed out makes it stale. Its slot is freed, which 
+	// may make room for the ranges of the new generation.
+	syncRanges();
+	for (size_t i = 0; i < staleRanges.size(); ++i) {
+		if (staleRanges[i].request.id == request.id) {
+			staleRanges.erase(staleRanges.begin() + i);
+			if ((uint32_t) (tail.load(std::memory_order_relaxed) - 
+								head.load(std::memory_order_relaxed)) < highWatermark) {
+				fillRanges();
+			}
+			
+			return 0;
+		}
+	}
+	
+	std::deque<RangeSlot>::iterator it = ranges.begin();
+	while (it != ranges.end() && it->request.id != request.id) { ++it; }
+	if (it == ranges.end() || it->done) { return 0; }
+	
+	if (length > it->request.length) { length = it->request.length; }
+	if (length < it->request.length && !eof && !end) {
+		// Split off the missing part as a new range, in the remainder of the slot.
+		RangeSlot rest = *it;
+		rest.request.id = nextRangeId++;
+		rest.request.offset += length;
+		rest.request.length -= length;
+		rest.start += length;
+		rest.assigned = false;
+		it->request.length = length;
+		it = ranges.insert(it + 1, rest) - 1;
+		if (dataRequestCV != 0) { dataRequestCV->notify_all(); }
+		rangeWaiter.notify();
+	}
+	
+	it->filled = length;
+	it->done = true;
+	
+	// Publish the completed ranges at the front.
+	uint64_t loctail = tail.load(std::memory_order_relaxed);
+	uint64_t start = loctail;
+	int64_t position = 0;
+	bool ended = false;
+	while (!ranges.empty() && ranges.front().done) {
+		RangeSlot front = ranges.front();
+		ranges.pop_front();
+		loctail += front.filled;
+		position = front.request.offset + front.filled;
+		if (front.filled < front.request.length) {
+			// End of the data. The later ranges are not needed.
+			for (RangeSlot &slot : ranges) {
+				if (slot.assigned && !slot.done) { staleRanges.push_back(slot); }
+			}
+			
+			ranges.clear();
+			ended = true;
+		}
+	}
+	
+	if (loctail == start && !ended) { return length; }
+	
+	// Set EOF after publishing the data, so that the reader does not stop short of it.
+	if (loctail != start) {
+		back = buffer + (loctail % capacity);
+		tail.store(loctail, std::memory_order_release);
+	}
+	
+	if (ended || (filesize > 0 && position >= filesize)) { eof = true; }
+	
+#ifdef DEBUG
+	std::cout << "Range " << request.id << " completed, tail: " << loctail << std::endl;
+#endif
+	
+	if (state == DBS_SEEKING) { completeSeek(rangeGeneration); }
+	
+	// Request more data if we are below the high watermark.
+	if ((uint32_t) (loctail - head.load(std::memory_order_relaxed)) < highWatermark) {
+		fillRanges();
+	}
+	else {
+		dataRequestPending = !ranges.empty();
+	}
+	
+	waiter.notify();
+	
+	return length;
+}
+
+
+// --- REFILL ---
+// Serve the pending data request by calling the producer with the free spans of the buffer. 
+// EOF is set once the data reaches the file size. For data of unknown size the producer calls
+// setEof() and returns 0 once no data is left.
+void StreamBuffer::refill() {
+	if (!dataRequestPending || !producer) { return; }
+	
+	uint32_t gen = dataRequestGeneration;
+	uint32_t size = dataRequestSize;
+	BufferSpan first, second;
+	uint32_t locfree = reserve(size, first, second, gen);
+	if (locfree == 0) {
+		dataRequestPending = false;
+		return;
+	}
+	
+	// The position of the tail in the streamed data follows from the start of its generation.
+	int64_t offset = generationOffset.load(std::memory_order_relaxed) + (int64_t) 
+		(tail.load(std::memory_order_relaxed) - generationBase.load(std::memory_order_relaxed));
+	uint32_t bytesWritten = producer(offset, locfree, first, second);
+	if (bytesWritten > locfree) { bytesWritten = locfree; }
+	
+#ifdef DEBUG
+	std::cout << "Producer wrote " << bytesWritten << " bytes at offset " << offset << std::endl;
+#endif
+	
+	// No data. Wait for the reader to ask again, unless a seek started a new request.
+	if (bytesWritten == 0) {
+		if (generation.load(std::memory_order_acquire) == gen) { dataRequestPending = false; }
+		return;
+	}
+	
+	// Set EOF after publishing the data, so that the reader does not stop short of it.
+	bool last = (filesize > 0 && offset + bytesWritten >= filesize);
+	if (commitWrite(bytesWritten, gen) > 0 && last) { setEof(true); }
+}
+
+
+// --- RUN REFILL ---
+// Refill task run on the executor. Keeps serving chained data requests, so that only one task
+// is queued at a time. A task that runs after the producer was stopped returns right away.
+void StreamBuffer::runRefill() {
+	while (refillRunning) {
+		refill();
+		if (dataRequestPending) { continue; }
+		
+		refillQueued = false;
+		if (!dataRequestPending || refillQueued.exchange(true)) { break; }
+	}
+	
+	// Last access to the buffer: once the count drops, stopRefill() returns and the buffer may
+	// be destroyed.
+	refillTasks.fetch_sub(1, std::memory_order_release);
+}
+
+
+// --- REFILL LOOP ---
+// Refill thread, serving data requests until stopped.
+void StreamBuffer::refillLoop() {
+	while (refillRunning) {
+		refillWaiter.waitUntil([this] { return dataRequestPending || !refillRunning; }, 
+							std::chrono::steady_clock::now() + std::chrono::milliseconds(100));
+		if (!refillRunning) { break; }
+		
+		refill();
+	}
+}
+
+
+// --- STOP REFILL ---
+// Stop calling the producer. Waits for the refill thread, and for the tasks handed to the 
+// executor, including those that are still queued.
+void StreamBuffer::stopRefill() {
+	refillRunning = false;
+	refillWaiter.notify();
+	if (refillThread.joinable()) { refillThread.join(); }
+	
+	while (refillTasks.load(std::memory_order_seq_cst) > 0) {
+		std::this_thread::yield();
+	}
+	
+	refillQueued = false;
+}
+
+
+// --- RESERVE RECORD ---
+// Obtain contiguous space for a record of 'length' bytes. The record never wraps around the 
+// end of the buffer: if it does not fit before the end, the rest of the buffer is padded and 
+// the record goes at the front. Depending on setRecordFull(), waits for space or fails right 
+// away if the buffer is full. Publish the record with commitRecordWrite().
+// Returns false if there is no room for the record, otherwise true.
+bool StreamBuffer::reserveRecord(uint32_t length, BufferSpan &record) {
+	record.data = back;
+	record.length = 0;
+	if (length == 0 || length > capacity - SB_RECORD_HEADER) { return false; }
+	
+	uint32_t pad = 0;
+	if (!mirrored && (uint32_t) (end - back) < SB_RECORD_HEADER + length) { pad = end - back; }
+	uint32_t needed = pad + SB_RECORD_HEADER + length;
+	if (needed > capacity) { return false; }
+	
+	uint32_t locfree = capacity - (tail.load(std::memory_order_relaxed) - lowCache);
+	if (locfree < needed) { locfree = writable(); }
+	if (locfree < needed && recordFull == DB_FULL_BLOCK) {
+		spaceWaiter.waitUntil([this, needed] { return writable() >= needed; }, 
+				std::chrono::steady_clock::now() + std::chrono::milliseconds(recordTimeout));
+		locfree = writable();
+	}
+	
+	if (locfree < needed) { return false; }
+	
+	uint8_t* frame = back;
+	if (pad > 0) {
+		// Mark the padding if the length prefix fits, the reader skips it. Otherwise the reader 
+		// knows that a gap smaller than a prefix is padding.
+		if (pad >= SB_RECORD_HEADER) { memcpy(back, &SB_RECORD_PADDING, SB_RECORD_HEADER); }
+		frame = buffer;
+	}
+	
+	record.data = frame + SB_RECORD_HEADER;
+	record.length = length;
+	
+	return true;
+}
+
+
+// --- COMMIT RECORD WRITE ---
+// Publish a record obtained with reserveRecord(). Its length may have been reduced.
+// Returns the length of the record.
+uint32_t StreamBuffer::commitRecordWrite(const BufferSpan &record) {
+	uint8_t* frame = record.data - SB_RECORD_HEADER;
+	uint32_t pad = (frame < back) ? end - back : 0;
+	memcpy(frame, &record.length, SB_RECORD_HEADER);
+	commitWrite(pad + SB_RECORD_HEADER + record.length);
+	
+	return record.length;
+}
+
+
+// --- WRITE RECORD ---
+// Write a record of 'length' bytes.
+// Returns the length of the record, or 0 if there is no room for it.
+uint32_t StreamBuffer::writeRecord(const char* data, uint32_t length) {
+	BufferSpan record;
+	if (!reserveRecord(length, record)) { return 0; }
+	
+	memcpy(record.data, data, length);
+	
+	return commitRecordWrite(record);
+}
+
+
+// --- PEEK RECORD ---
+// Obtain the next whole record without copying it. It stays valid until commitRecord().
+// Returns the length of the record, or 0 if no record is available.
+uint32_t StreamBuffer::peekRecord(BufferSpan &record) {
+	record.data = index;
+	record.length = 0;
+	for (;;) {
+		BufferSpan first, second;
+		uint32_t locunread = peek(first, second);
+		if (locunread == 0) { return 0; }
+		
+		// Skip the padding in front of a record that went to the front of the buffer.
+		uint32_t toEnd = end - index;
+		if (!mirrored && toEnd < SB_RECORD_HEADER) {
+			commit(toEnd);
+			continue;
+		}
+		
+		if (locunread < SB_RECORD_HEADER) { return 0; }
+		
+		uint32_t length;
+		memcpy(&length, index, SB_RECORD_HEADER);
+		if (length == SB_RECORD_PADDING) {
+			commit(toEnd);
+			continue;
+		}
+		
+		// Compare without adding to the length, which wraps if the header is corrupt.
+		if (length > locunread - SB_RECORD_HEADER) { return 0; }
+		
+		record.data = index + SB_RECORD_HEADER;
+		record.length = length;
+		return length;
+	}
+}
+
+
+// --- COMMIT RECORD ---
+// Mark the record obtained with peekRecord() as read.
+// Returns the length of the record, or 0 if no record was available.
+uint32_t StreamBuffer::commitRecord() {
+	BufferSpan record;
+	uint32_t length = peekRecord(record);
+	if (length == 0) { return 0; }
+	
+	commit(SB_RECORD_HEADER + length);
+	
+	return length;
+}
+
+
+// --- READ RECORD ---
+// Copy the next record into the provided buffer, if it fits in 'len' bytes.
+// Returns the length of the record, or 0 if no record is available or it does not fit.
+uint32_t StreamBuffer::readRecord(uint32_t len, uint8_t* bytes) {
+	BufferSpan record;
+	if (peekRecord(record) == 0 || record.length > len) { return 0; }
+	
+	memcpy(bytes, record.data, record.length);
+	
+	return commitRecord();
+}
+
+
+// --- SET EOF ---
+// Set the End-Of-File status of the file being streamed.
+void StreamBuffer::setEof(bool eof) {
+	this->eof = eof;
+	if (eof) { waiter.notify(); }
+}
+
+
+// --- IS EOF ---
+bool StreamBuffer::isEof() {
+	return eof;
+}
@@ -0,0 +1,302 @@
+/*
+	streambuffer.h - Stream Buffer header.
+	
+	Revision 0
+	
+	Features:
+			- Provides an instance-based ring buffer, one per streaming session.
+			- Mirrored virtual memory mapping for page-aligned capacities (Linux).
+			- Monotonic 64-bit head & tail counters, owned by the reader & writer respectively.
+			- Configurable request size and refill watermarks.
+			- Seeking back into already read data without a new request.
+			- Skipping ahead in unread data without copying or a new request.
+			- Blocking reads with deadlines, woken up by the writer.
+			- Selectable wait strategy for the reader.
+			- Asynchronous seeking, with cancellation of a pending seek.
+			- Generation-tagged writes, so that seeks never wait for in-flight requests. Seeks wait
+				for the in-flight request of an untagged writer, as before.
+			- Pipelined range requests, committed in offset order as they complete.
+			- Pull-mode producer callback, called on a refill thread or a caller's executor.
+			- Record mode with length-prefixed frames that never tear across the wrap.
+			- Vectored readv() & writev() over lists of segments, with a single commit per call.
+			- Draining unread data straight to a file descriptor with sendmsg() or writev() (Linux).
+			- Allocation options: huge pages, NUMA node binding, prefaulting & locking (Linux).
+	
+	Notes:
+			- The static DataBuffer API wraps a default instance of this class.
+	
+	2026/10/17
+*/
+
+
+#ifndef STREAMBUFFER_H
+#define STREAMBUFFER_H
+
+
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <condition_variable>
+#include <string>
+#include <cstdint>
+#include <chrono>
+#include <future>
+#include <deque>
+#include <vector>
+#include <thread>
+
+#include "bufferwaiter.h"
+#include "cacheline.h"
+
+
+typedef std::function<void(uint32_t, int64_t)> SeekRequestCallback;
+
+// Contiguous section of the ring buffer, used by the zero-copy API.
+struct BufferSpan {
+	uint8_t* data;
+	uint32_t length;
+};
+
+// Pull-mode producer. Gets the stream position and size of the requested data, and the free 
+// spans to write it into. Returns the number of bytes written.
+typedef std::function<uint32_t(int64_t, uint32_t, BufferSpan&, BufferSpan&)> ProducerCallback;
+
+// Runs a refill task on a thread of the caller's choosing.
+typedef std::function<void(std::function<void()>)> RefillExecutor;
+
+// Range of the streamed data requested from the client, in range request mode.
+struct RangeRequest {
+	uint64_t id;			// Identifies the range to reserveRange() & completeRange().
+	int64_t offset;			// Position of the range in the streamed data.
+	uint32_t length;		// Number of bytes requested.
+	uint32_t generation;	// Generation the range was requested for.
+};
+
+// What a record writer does when the buffer has no room for a frame.
+enum DataBufferFull {
+	DB_FULL_FAIL = 0,
+	DB_FULL_BLOCK
+};
+
+// Allocation options for the buffer memory, set before init(). Can be combined.
+enum DataBufferAlloc {
+	DB_ALLOC_DEFAULT = 0,
+	DB_ALLOC_HUGE_PAGES = 1,	// Transparent huge pages, if the kernel allows for them.
+	DB_ALLOC_HUGETLB = 2,		// Explicit huge pages from the reserved pool.
+	DB_ALLOC_NUMA = 4,			// Bind the pages to a NUMA node.
+	DB_ALLOC_PREFAULT = 8,		// Touch every page in init(), so that reads never page fault.
+	DB_ALLOC_LOCK = 16			// Lock the pages in memory.
+};
+
+enum DataBufferSeek {
+	DB_SEEK_START = 0,
+	DB_SEEK_CURRENT,
+	DB_SEEK_END
+};
+
+
+class StreamBuffer {
+	enum BufferState {
+		DBS_IDLE = 0,
+		DBS_BUFFERING,
+		DBS_SEEKING
+	};
+	
+	// Slot reserved in the buffer for a requested range.
+	struct RangeSlot {
+		RangeRequest request;
+		uint64_t start;		// Tail value at which the slot starts.
+		uint32_t filled;	// Number of bytes delivered, once done.
+		bool assigned;		// Handed out to the client.
+		bool done;
+	};
+	
+	// Read-only after init(), shared by reader and writer.
+	uint8_t* buffer;		// Pointer to buffer.
+	bool mirrored;			// Buffer pages are mapped twice, back to back.
+	uint8_t* end;			// Pointer to buffer end (idx Nsize).
+	uint32_t capacity;		// Total capacity of buffer in bytes.
+	size_t mapSize;			// Length of the memory mapping, or 0 if allocated with new.
+	uint32_t allocated;		// Allocation options that were applied.
+	
+	// Reader-owned state. Padding keeps it off the cache lines of the writer.
+	uint8_t readerPad[SB_CACHE_LINE_SIZE];
+	std::atomic<uint64_t> head;	// Read position since reset. Moves back when rewinding.
+	std::atomic<uint64_t> low;	// Oldest byte kept as history. Monotonic, written by the reader.
+	uint64_t tailCache;		// Reader's copy of 'tail'.
+	uint8_t* index;			// Pointer to first unread byte or buffer start.
+	int64_t byteIndex;		// First unread byte index into the media file data.
+	uint32_t historyRetain;	// Number of read bytes kept as history.
+	bool rebasePending;		// Waiting for the writer to start on the current generation.
+	int drainFd;			// Descriptor of the last drain() call, or -1.
+	bool drainSocket;		// That descriptor is a socket.
+	
+	// Writer-owned state.
+	uint8_t writerPad[SB_CACHE_LINE_SIZE];
+	std::atomic<uint64_t> tail;	// Total bytes written since reset. Only written by the writer.
+	uint64_t lowCache;		// Writer's copy of 'low'.
+	uint8_t* back;			// Pointer to back of data in buffer (last byte + 1).
+	uint64_t lowFloor;		// Start of the writer's generation. Older data may be overwritten.
+	std::atomic<uint32_t> writerGeneration;	// Generation of the data the writer publishes.
+	std::atomic<uint64_t> generationBase;		// Tail at which that generation's data starts.
+	
+	// Shared state.
+	uint8_t sharedPad[SB_CACHE_LINE_SIZE];
+	int64_t filesize;		// Size of the data being streamed, in bytes.
+	uint32_t historySize;	// Requested number of read bytes to keep as history.
+	std::atomic<bool> eof;
+	std::atomic<BufferState> state;
+	SeekRequestCallback seekRequestCallback;
+	std::condition_variable* dataRequestCV;
+	uint32_t requestSize;		// Preferred number of bytes per data request.
+	uint32_t lowWatermark;		// Unread bytes at or below which the reader requests data.
+	uint32_t highWatermark;		// Unread bytes below which requests are chained.
+	std::atomic<uint32_t> dataRequestSize;	// Bytes asked for by the current data request.
+	std::atomic<uint32_t> generation;		// Bumped on every seek & reset. Written by the reader.
+	std::atomic<uint32_t> dataRequestGeneration;	// Generation of the current data request.
+	std::atomic<int64_t> generationOffset;			// Stream position the generation starts at.
+	BufferWaiter waiter;		// Used by the reader to wait for the writer.
+	std::atomic<bool> seekRequestPending;
+	std::mutex seekMutex;			// Protects the pending seek.
+	std::promise<int64_t> seekPromise;	// Completion of the pending seek.
+	bool seekPending;				// The seek promise is not fulfilled yet.
+	int64_t seekTarget;				// Offset of the pending seek.
+	uint32_t seekGeneration;		// Generation started by the pending seek.
+	std::atomic<bool> seekDeferred;	// Seek waits for the request of an untagged writer.
+	int64_t seekOrigin;				// Stream position of the generation a deferred seek left.
+	uint32_t seekOriginGeneration;	// That generation.
+	std::atomic<bool> taggedWrites;	// The writer passes the generation with its data.
+	uint32_t sessionHandle;		// Active session this buffer is associated with.
+	
+	// Range request state. In range request mode the writer state is protected by 'rangeMutex'.
+	uint32_t maxRanges;				// Maximum outstanding ranges, 0 for single requests.
+	std::mutex rangeMutex;
+	std::deque<RangeSlot> ranges;	// Ranges of the current generation, in offset order.
+	std::vector<RangeSlot> staleRanges;	// Handed out for older generations, not completed yet.
+	uint32_t rangeGeneration;		// Generation of the ranges in 'ranges'.
+	uint64_t rangeEnd;				// Tail value at the end of the last reserved slot.
+	int64_t rangeOffset;			// Stream position of the next range.
+	uint64_t nextRangeId;
+	BufferWaiter rangeWaiter;		// Used by fetchers to wait for ranges to be issued.
+	
+	// Pull-mode producer state.
+	ProducerCallback producer;
+	RefillExecutor refillExecutor;
+	std::thread refillThread;
+	std::atomic<bool> refillRunning;	// The producer is being called.
+	std::atomic<bool> refillQueued;		// A refill task is queued on the executor.
+	std::atomic<uint32_t> refillTasks;	// Executor tasks queued or running.
+	BufferWaiter refillWaiter;			// Used by the refill thread to wait for requests.
+	
+	// Record mode state.
+	DataBufferFull recordFull;		// Whether record writers wait for space.
+	uint32_t recordTimeout;			// Maximum wait for space, in milliseconds.
+	BufferWaiter spaceWaiter;		// Used by record writers to wait for the reader.
+	
+	// Allocation options.
+	uint32_t allocFlags;	// Requested DataBufferAlloc flags.
+	int allocNode;			// NUMA node to bind to, or -1 for the node of the calling thread.
+	
+	bool allocateMirrored(uint32_t capacity);
+	bool mapMirrored(uint32_t capacity, bool hugetlb);
+	bool allocateMapped(uint32_t capacity);
+	void applyAllocation();
+	void release();
+	uint32_t readable();
+	bool rebase();
+	bool adoptGeneration(uint32_t gen);
+	uint32_t publishWrite(uint32_t length, uint32_t gen);
+	uint32_t writable();
+	uint32_t blockSize();
+	void triggerDataRequest(uint32_t locfree);
+	void updateHistory();
+	void rewind(uint32_t len);
+	uint32_t freeBytes();
+	void clear();
+	void startSeek(int64_t offset);
+	void requestSeek(int64_t offset);
+	bool startDeferredSeek();
+	void restoreSeekOrigin();
+	void cancelSeek();
+	bool completeSeek(uint32_t gen);
+	uint32_t copyOut(uint32_t len, uint8_t* bytes);
+	bool waitForData(uint32_t min, std::chrono::steady_clock::time_point deadline);
+	void syncRanges();
+	void fillRanges();
+	void issueRanges();
+	void refill();
+	void runRefill();
+	void refillLoop();
+	void stopRefill();
+
+public:
+	StreamBuffer(DataBufferWait strategy = DB_WAIT_CONDITION);
+	~StreamBuffer();
+	
+	StreamBuffer(const StreamBuffer&) = delete;
+	StreamBuffer& operator=(const StreamBuffer&) = delete;
+	
+	bool init(uint32_t capacity);
+	bool cleanup();
+	bool isMirrored();
+	void setAllocation(uint32_t flags, int node = -1);
+	uint32_t getAllocation();
+	void setSeekRequestCallback(SeekRequestCallback cb);
+	void setDataRequestCondition(std::condition_variable* condition);
+	void setRequestSize(uint32_t size);
+	void setWatermarks(uint32_t low, uint32_t high);
+	uint32_t getDataRequestSize();
+	uint32_t getDataRequestGeneration();
+	uint32_t getGeneration();
+	void setHistorySize(uint32_t size);
+	void setWaitStrategy(DataBufferWait strategy);
+	void setRangeRequests(uint32_t count);
+	void setProducer(ProducerCallback cb, RefillExecutor executor = nullptr);
+	void setRecordFull(DataBufferFull mode, uint32_t timeout);
+	void setSessionHandle(uint32_t handle);
+	uint32_t getSessionHandle();
+	void setFileSize(int64_t size);
+	int64_t getFileSize();
+	bool start();
+	void requestData();
+	bool reset();
+	int64_t seek(DataBufferSeek mode, int64_t offset);
+	std::shared_future<int64_t> seekAsync(DataBufferSeek mode, int64_t offset);
+	int64_t tell();
+	bool seeking();
+	uint32_t read(uint32_t len, uint8_t* bytes);
+	uint32_t readAtLeast(uint32_t min, uint32_t len, uint8_t* bytes, 
+										std::chrono::steady_clock::time_point deadline);
+	uint32_t readExact(uint32_t len, uint8_t* bytes, std::chrono::steady_clock::time_point deadline);
+	uint32_t readToEof(uint32_t len, uint8_t* bytes, std::chrono::steady_clock::time_point deadline);
+	uint32_t readv(const BufferSpan* segments, uint32_t count);
+	uint32_t peek(BufferSpan &first, BufferSpan &second);
+	uint32_t commit(uint32_t len);
+	uint32_t skip(uint32_t len);
+	int64_t drain(int fd, uint32_t max = UINT32_MAX);
+	uint32_t write(std::string &data);
+	uint32_t write(const char* data, uint32_t length);
+	uint32_t write(const char* data, uint32_t length, uint32_t generation);
+	uint32_t writev(const BufferSpan* segments, uint32_t count);
+	uint32_t writev(const BufferSpan* segments, uint32_t count, uint32_t generation);
+	uint32_t reserve(uint32_t max, BufferSpan &first, BufferSpan &second);
+	uint32_t reserve(uint32_t max, BufferSpan &first, BufferSpan &second, uint32_t generation);
+	uint32_t commitWrite(uint32_t length);
+	uint32_t commitWrite(uint32_t length, uint32_t generation);
+	bool nextRange(RangeRequest &request);
+	bool nextRange(RangeRequest &request, std::chrono::steady_clock::time_point deadline);
+	uint32_t reserveRange(const RangeRequest &request, BufferSpan &first, BufferSpan &second);
+	uint32_t completeRange(const RangeRequest &request, uint32_t length, bool end = false);
+	bool reserveRecord(uint32_t length, BufferSpan &record);
+	uint32_t commitRecordWrite(const BufferSpan &record);
+	uint32_t writeRecord(const char* data, uint32_t length);
+	uint32_t peekRecord(BufferSpan &record);
+	uint32_t commitRecord();
+	uint32_t readRecord(uint32_t len, uint8_t* bytes);
+	void setEof(bool eof);
+	bool isEof();
+	
+	std::atomic<bool> dataRequestPending;
+};
+
+#endif
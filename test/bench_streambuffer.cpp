@@ -0,0 +1,269 @@
+/*
+	bench_streambuffer.cpp - Read & write throughput benchmark for the StreamBuffer class.
+	
+*/
+
+
+#include "../src/streambuffer.h"
+#include "../src/ringbuffer.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Stream 'total' bytes through the buffer in 'writeSize' writes, consumed with 'readSize' reads.
+// Returns the throughput in MB/s.
+
+double bench_stream(StreamBuffer & sb, uint64_t total, uint32_t writeSize, uint32_t readSize)
+{
+	std::vector<char> in(writeSize, 'x');
+	std::vector<uint8_t> out(readSize);
+	
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	uint64_t done = 0;
+	while (done < total) {
+		// Fill the buffer, then drain it.
+		while (sb.write(in.data(), writeSize) == writeSize) { }
+		
+		uint32_t bytesRead;
+		while ((bytesRead = sb.read(readSize, out.data())) > 0) {
+			done += bytesRead;
+		}
+	}
+	
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(end - begin).count();
+	return (done / (1024.0 * 1024.0)) / seconds;
+}
+
+
+void bench_case(std::string const & title, uint32_t capacity, uint64_t total, uint32_t readSize)
+{
+	StreamBuffer sb;
+	sb.init(capacity);
+	sb.setEof(true);	// No data requests.
+	
+	// Warm up, then take the best of three runs.
+	bench_stream(sb, total / 4, 64 * 1024, readSize);
+	double best = 0;
+	for (int i = 0; i < 3; ++i) {
+		double rate = bench_stream(sb, total, 64 * 1024, readSize);
+		if (rate > best) { best = rate; }
+	}
+	
+	std::cout << title << (sb.isMirrored() ? " (mirrored)" : "") 
+				<< " read size " << readSize << ": " << (uint64_t) best << " MB/s\n";
+}
+
+
+// Stream 'total' bytes from a writer thread to a reader thread running at the same time, in 
+// 'size' byte writes and reads. This is where the reader & writer owned counters count: each 
+// side only reloads the counter of the other when its cached copy runs out.
+// Returns the throughput in MB/s.
+
+double bench_threads(StreamBuffer & sb, uint64_t total, uint32_t size)
+{
+	std::vector<char> in(size, 'x');
+	std::vector<uint8_t> out(size);
+	
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	std::thread writer([&sb, &in, total, size] {
+		uint64_t written = 0;
+		while (written < total) {
+			uint32_t bytesWritten = sb.write(in.data(), size);
+			if (bytesWritten == 0) { std::this_thread::yield(); }	// Full.
+			written += bytesWritten;
+		}
+	});
+	
+	uint64_t done = 0;
+	while (done < total) {
+		uint32_t bytesRead = sb.read(size, out.data());
+		if (bytesRead == 0) { std::this_thread::yield(); }		// Empty.
+		done += bytesRead;
+	}
+	
+	writer.join();
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(end - begin).count();
+	return (done / (1024.0 * 1024.0)) / seconds;
+}
+
+
+void bench_threads_case(uint64_t total, uint32_t size)
+{
+	StreamBuffer sb;
+	sb.init(1024 * 1024);
+	sb.setEof(true);	// No data requests, reads return right away.
+	
+	double best = 0;
+	for (int i = 0; i < 3; ++i) {
+		double rate = bench_threads(sb, total, size);
+		if (rate > best) { best = rate; }
+	}
+	
+	std::cout << "1 MiB buffer, writer & reader threads, size " << size << ": " 
+				<< (uint64_t) best << " MB/s\n";
+}
+
+
+// Stream 'total' bytes in batches of 'count' small segments, written one write() call at a 
+// time or with a single writev() call per batch, and read the same way.
+// Returns the throughput in MB/s.
+
+double bench_segments(StreamBuffer & sb, uint64_t total, uint32_t count, bool vectored)
+{
+	const uint32_t segmentSize = 64;
+	std::vector<uint8_t> in(count * segmentSize, 'x');
+	std::vector<uint8_t> out(count * segmentSize);
+	std::vector<BufferSpan> inSegments(count);
+	std::vector<BufferSpan> outSegments(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		inSegments[i].data = in.data() + i * segmentSize;
+		inSegments[i].length = segmentSize;
+		outSegments[i].data = out.data() + i * segmentSize;
+		outSegments[i].length = segmentSize;
+	}
+	
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	uint64_t done = 0;
+	while (done < total) {
+		if (vectored) {
+			sb.writev(inSegments.data(), count);
+			done += sb.readv(outSegments.data(), count);
+		}
+		else {
+			for (uint32_t i = 0; i < count; ++i) {
+				sb.write((const char*) inSegments[i].data, segmentSize);
+			}
+			for (uint32_t i = 0; i < count; ++i) {
+				done += sb.read(segmentSize, outSegments[i].data);
+			}
+		}
+	}
+	
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(end - begin).count();
+	return (done / (1024.0 * 1024.0)) / seconds;
+}
+
+
+void bench_segments_case(uint64_t total, uint32_t count)
+{
+	StreamBuffer sb;
+	sb.init(1024 * 1024);
+	sb.setEof(true);
+	
+	double rates[2] = { 0, 0 };
+	for (int vectored = 0; vectored < 2; ++vectored) {
+		for (int i = 0; i < 3; ++i) {
+			double rate = bench_segments(sb, total, count, vectored == 1);
+			if (rate > rates[vectored]) { rates[vectored] = rate; }
+		}
+	}
+	
+	std::cout << count << " x 64 byte segments: write/read " << (uint64_t) rates[0] 
+				<< " MB/s, writev/readv " << (uint64_t) rates[1] << " MB/s\n";
+}
+
+// Large buffer with the given allocation options. The first pass touches every page for the 
+// first time, unless prefaulted. Steady state is the best of three later passes.
+
+void bench_alloc_case(std::string const & title, uint32_t flags, uint64_t total)
+{
+	const uint32_t capacity = 64 * 1024 * 1024;
+	StreamBuffer sb;
+	sb.setAllocation(flags);
+	
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	sb.init(capacity);
+	sb.setEof(true);
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	double initMs = std::chrono::duration<double, std::milli>(end - begin).count();
+	
+	double first = bench_stream(sb, capacity, 64 * 1024, 32 * 1024);
+	double best = 0;
+	for (int i = 0; i < 3; ++i) {
+		double rate = bench_stream(sb, total, 64 * 1024, 32 * 1024);
+		if (rate > best) { best = rate; }
+	}
+	
+	std::cout << "64 MiB " << title << " (applied " << sb.getAllocation() << "): init " 
+				<< (uint64_t) initMs << " ms, first pass " << (uint64_t) first << " MB/s, steady " 
+				<< (uint64_t) best << " MB/s\n";
+}
+
+// Same as bench_case(), with the compile-time sized RingBuffer template.
+
+typedef RingBuffer<uint8_t, 1024 * 1024> ByteRing;
+
+double bench_ring(ByteRing & rb, uint64_t total, uint32_t writeSize, uint32_t readSize)
+{
+	std::vector<uint8_t> in(writeSize, 'x');
+	std::vector<uint8_t> out(readSize);
+	
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	uint64_t done = 0;
+	while (done < total) {
+		while (rb.write(in.data(), writeSize) == writeSize) { }
+		
+		uint32_t bytesRead;
+		while ((bytesRead = rb.read(out.data(), readSize)) > 0) {
+			done += bytesRead;
+		}
+	}
+	
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(end - begin).count();
+	return (done / (1024.0 * 1024.0)) / seconds;
+}
+
+
+void bench_ring_case(uint64_t total, uint32_t readSize)
+{
+	std::unique_ptr<ByteRing> rb(new ByteRing);
+	
+	bench_ring(*rb, total / 4, 64 * 1024, readSize);
+	double best = 0;
+	for (int i = 0; i < 3; ++i) {
+		double rate = bench_ring(*rb, total, 64 * 1024, readSize);
+		if (rate > best) { best = rate; }
+	}
+	
+	std::cout << "1 MiB RingBuffer<uint8_t>  read size " << readSize << ": " << (uint64_t) best << " MB/s\n";
+}
+
+int main()
+{
+	const uint64_t total = 1024ULL * 1024 * 1024;
+	
+	uint32_t sizes[] = { 64, 1024, 32 * 1024, 128 * 1024 };
+	for (uint32_t size : sizes) {
+		uint64_t amount = (size < 1024) ? total / 16 : total;
+		bench_case("1 MiB buffer", 1024 * 1024, amount, size);
+		bench_case("1 MB buffer ", 1000 * 1000, amount, size);
+		bench_ring_case(amount, size);
+	}
+	
+	bench_threads_case(total / 16, 64);
+	bench_threads_case(total, 4096);
+	bench_threads_case(total, 64 * 1024);
+	
+	bench_segments_case(total / 4, 4);
+	bench_segments_case(total / 4, 16);
+	
+	bench_alloc_case("default       ", DB_ALLOC_DEFAULT, total);
+	bench_alloc_case("huge pages    ", DB_ALLOC_HUGE_PAGES, total);
+	bench_alloc_case("hugetlb       ", DB_ALLOC_HUGETLB, total);
+	bench_alloc_case("numa          ", DB_ALLOC_NUMA, total);
+	bench_alloc_case("prefault      ", DB_ALLOC_PREFAULT, total);
+	bench_alloc_case("prefault, lock", DB_ALLOC_PREFAULT | DB_ALLOC_LOCK, total);
+	bench_alloc_case("combined      ", DB_ALLOC_HUGE_PAGES | DB_ALLOC_NUMA | DB_ALLOC_PREFAULT 
+												| DB_ALLOC_LOCK, total);
+	
+	return 0;
+}
@@ -0,0 +1,151 @@
+/*
+	test_broadcastbuffer.cpp - Tests for the single producer, multiple consumer BroadcastBuffer.
+
+*/
+
+
+#include "../src/broadcastbuffer.h"
+#include "testpattern.h"
+
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+
+// Write 'length' bytes of the test pattern, starting at stream position 'offset'.
+
+uint32_t writePattern(BroadcastBuffer & bb, uint64_t offset, uint32_t length)
+{
+	std::vector<uint8_t> data(length);
+	fillPattern(data.data(), length, offset);
+	return bb.write((const char*) data.data(), length);
+}
+
+// Read 'length' bytes for a reader and check them against the pattern at 'offset'.
+
+bool readPattern(BroadcastBuffer & bb, int reader, uint64_t offset, uint32_t length)
+{
+	std::vector<uint8_t> data(length);
+	if (bb.read(reader, length, data.data()) != length) { return false; }
+	return checkPattern(data.data(), length, offset);
+}
+
+
+int main()
+{
+	BroadcastBuffer bb;
+	assert(bb.init(4096, 4));
+	
+	// Every reader gets all data. Free space follows the slowest reader.
+	int a = bb.attach();
+	int b = bb.attach();
+	assert(a >= 0 && b >= 0 && a != b);
+	assert(writePattern(bb, 0, 4096) == 4096);
+	assert(readPattern(bb, a, 0, 4096));
+	assert(writePattern(bb, 4096, 1024) == 0);
+	assert(readPattern(bb, b, 0, 1000));
+	assert(writePattern(bb, 4096, 1024) == 1000);
+	assert(readPattern(bb, a, 4096, 1000));
+	assert(readPattern(bb, b, 1000, 3096 + 1000));
+	std::cout << "Broadcast: OK\n";
+	
+	// A reader attached later starts at the new data.
+	int c = bb.attach();
+	uint8_t byte;
+	assert(bb.read(c, 1, &byte) == 0);
+	assert(writePattern(bb, 5096, 100) == 100);
+	assert(readPattern(bb, c, 5096, 100));
+	bb.detach(c);
+	assert(!bb.isAttached(c));
+	assert(readPattern(bb, a, 5096, 100));
+	assert(readPattern(bb, b, 5096, 100));
+	
+	// Lag drop: a reader in the way of the writer loses its oldest data.
+	bb.setLagPolicy(BB_LAG_DROP, 1024);
+	assert(writePattern(bb, 5196, 4096) == 4096);
+	assert(readPattern(bb, a, 5196, 4096));
+	assert(readPattern(bb, b, 5196, 512));
+	assert(writePattern(bb, 9292, 2048) == 2048);
+	assert(bb.dropped(a) == 0);
+	assert(bb.dropped(b) == 2048 - 512);
+	assert(readPattern(bb, b, 5196 + 2048, 2048 + 2048));
+	assert(readPattern(bb, a, 9292, 2048));
+	
+	// Data dropped between peek() and commit() is not committed, and the fresh data behind it 
+	// stays unread.
+	BroadcastBuffer pb;
+	assert(pb.init(1024, 1));
+	pb.setLagPolicy(BB_LAG_DROP, 0);
+	int p = pb.attach();
+	BufferSpan first, second;
+	assert(writePattern(pb, 0, 800) == 800);
+	assert(pb.peek(p, first, second) == 800);
+	assert(writePattern(pb, 800, 1000) == 1000);
+	assert(pb.dropped(p) == 776);
+	assert(pb.commit(p, 800) == 0);
+	assert(readPattern(pb, p, 776, 1024));
+	std::cout << "Lag drop: OK\n";
+	
+	// Readers within the maximum lag still hold up the writer.
+	bb.setLagPolicy(BB_LAG_DROP, 3584);
+	assert(writePattern(bb, 11340, 3584) == 3584);
+	assert(readPattern(bb, b, 11340, 3584));
+	assert(writePattern(bb, 14924, 1024) == 512);
+	assert(bb.dropped(a) == 0);
+	assert(readPattern(bb, a, 11340, 3584 + 512));
+	assert(readPattern(bb, b, 14924, 512));
+	
+	// Lag detach: a reader in the way of the writer is detached.
+	bb.setLagPolicy(BB_LAG_DETACH, 0);
+	assert(writePattern(bb, 15436, 4096) == 4096);
+	assert(readPattern(bb, a, 15436, 4096));
+	assert(writePattern(bb, 19532, 1024) == 1024);
+	assert(!bb.isAttached(b));
+	assert(bb.read(b, 1, &byte) == 0);
+	assert(bb.isAttached(a));
+	assert(readPattern(bb, a, 19532, 1024));
+	assert(bb.attach() == b);
+	std::cout << "Lag detach: OK\n";
+	
+	// Concurrent readers all see the full stream while the writer is held up by them.
+	BroadcastBuffer cb;
+	assert(cb.init(64 * 1024, 3));
+	const uint32_t totalSize = 4 * 1024 * 1024;
+	int readers[3];
+	for (int i = 0; i < 3; ++i) { readers[i] = cb.attach(); }
+	
+	std::vector<std::thread> threads;
+	std::atomic<uint32_t> good = { 0 };
+	for (int i = 0; i < 3; ++i)
+	{
+		threads.push_back(std::thread([&cb, &good, &readers, totalSize, i] {
+			std::vector<uint8_t> data(4096);
+			uint64_t offset = 0;
+			bool ok = true;
+			while (offset < totalSize)
+			{
+				uint32_t n = cb.read(readers[i], 1000 + i * 1000, data.data());
+				ok = ok && checkPattern(data.data(), n, offset);
+				offset += n;
+				if (n == 0) { std::this_thread::yield(); }
+			}
+			if (ok) { good++; }
+		}));
+	}
+	
+	uint64_t written = 0;
+	while (written < totalSize)
+	{
+		uint32_t n = writePattern(cb, written, 3000);
+		written += n;
+		if (n == 0) { std::this_thread::yield(); }
+	}
+	
+	for (std::thread &t : threads) { t.join(); }
+	assert(good == 3);
+	std::cout << "Concurrent readers: OK\n";
+	
+	std::cout << "Done.\n";
+	return 0;
+}
@@ -0,0 +1,117 @@
+/*
+	test_chunkbuffer.cpp - Tests for the chunk queue buffer.
+
+*/
+
+
+#include "../src/chunkbuffer.h"
+#include "testpattern.h"
+
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+
+// Chunk of 'length' bytes continuing the sequence at 'value'.
+
+std::vector<uint8_t> makeChunk(uint32_t length, uint8_t value)
+{
+	std::vector<uint8_t> data(length);
+	for (uint32_t i = 0; i < length; ++i) { data[i] = value + i; }
+	return data;
+}
+
+
+int main()
+{
+	ChunkBuffer cb;
+	assert(!cb.init(0));
+	assert(cb.init(4));
+	
+	// Chunks are moved in, not copied.
+	std::vector<uint8_t> first = makeChunk(100, 0);
+	const uint8_t* firstData = first.data();
+	assert(cb.write(std::move(first)));
+	std::unique_ptr<uint8_t[]> second(new uint8_t[50]);
+	for (uint32_t i = 0; i < 50; ++i) { second[i] = 100 + i; }
+	const uint8_t* secondData = second.get();
+	assert(cb.write(std::move(second), 50));
+	assert(!cb.write(std::vector<uint8_t>()));		// Empty.
+	assert(cb.readable() == 150);
+	
+	// One span per chunk, pointing at the producer's memory.
+	BufferSpan spans[4];
+	assert(cb.peek(spans, 4) == 2);
+	assert(spans[0].data == firstData && spans[0].length == 100);
+	assert(spans[1].data == secondData && spans[1].length == 50);
+	assert(cb.commit(30) == 30);
+	assert(cb.peek(spans, 1) == 1);
+	assert(spans[0].data == firstData + 30 && spans[0].length == 70);
+	
+	// Reads cross chunk boundaries.
+	uint8_t data[200];
+	assert(cb.read(90, data) == 90);
+	for (uint32_t i = 0; i < 90; ++i) { assert(data[i] == 30 + i); }
+	assert(cb.read(200, data) == 30);
+	for (uint32_t i = 0; i < 30; ++i) { assert(data[i] == 120 + i); }
+	assert(cb.readable() == 0);
+	assert(cb.commit(10) == 0);
+	
+	// Consumed chunks come back to the producer, with their memory.
+	BufferChunk chunk;
+	assert(cb.reclaim(chunk));
+	assert(chunk.data() == firstData && chunk.vector.capacity() >= 100);
+	assert(cb.reclaim(chunk));
+	assert(chunk.data() == secondData);
+	assert(!cb.reclaim(chunk));
+	std::cout << "Chunks & spans: OK\n";
+	
+	// A full queue leaves the chunk with the producer.
+	for (int i = 0; i < 4; ++i) { assert(cb.write(makeChunk(10, 0))); }
+	std::vector<uint8_t> extra = makeChunk(10, 0);
+	assert(!cb.write(std::move(extra)));
+	assert(extra.size() == 10);
+	assert(cb.commit(40) == 40);
+	assert(cb.write(std::move(extra)));
+	std::cout << "Full queue: OK\n";
+	
+	// Producer thread reusing the chunks it reclaims, reader checking the sequence.
+	ChunkBuffer tb;
+	assert(tb.init(16));
+	const uint64_t total = 50 * 1000 * 1000;
+	std::thread producer([&tb, total] {
+		uint64_t written = 0;
+		std::vector<uint8_t> data;
+		while (written < total)
+		{
+			BufferChunk reused;
+			if (data.empty() && tb.reclaim(reused)) { data = std::move(reused.vector); }
+			uint32_t length = 1000 + (written / 7) % 60000;
+			if (length > total - written) { length = total - written; }
+			data.resize(length);
+			fillPattern(data.data(), length, written);
+			if (!tb.write(std::move(data))) { std::this_thread::yield(); continue; }
+			data = std::vector<uint8_t>();
+			written += length;
+		}
+	});
+	
+	std::vector<uint8_t> buffer(37 * 1024);
+	uint64_t received = 0;
+	bool ok = true;
+	while (received < total)
+	{
+		uint32_t n = tb.read(buffer.size(), buffer.data());
+		if (n == 0) { std::this_thread::yield(); continue; }
+		ok = ok && checkPattern(buffer.data(), n, received);
+		received += n;
+	}
+	
+	producer.join();
+	assert(ok);
+	std::cout << "Concurrent chunks: OK\n";
+	
+	std::cout << "Done.\n";
+	return 0;
+}
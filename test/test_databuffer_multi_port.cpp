@@ -12,13 +12,14 @@
 #include <thread>
 #include <string>
 #include <atomic>
+#include <cstring>
 
 
 std::condition_variable gCon;
 std::mutex gMutex;
 
 uint32_t chunk_size = 200 * 1024; // 200 kB
-const char* chunk;
+uint8_t pattern = 0;
 std::thread* readThread;
 
 std::atomic<bool> running = { true };
@@ -29,6 +30,19 @@ std::condition_variable dataWriteCv;
 std::mutex dataWriteMtx;
 
 
+// --- WRITE CHUNK ---
+// Write a chunk straight into the free space of the buffer, as a network receive would.
+uint32_t writeChunk(uint32_t size) {
+	BufferSpan first, second;
+	DataBuffer::reserve(size, first, second);
+	memset(first.data, pattern, first.length);
+	memset(second.data, pattern, second.length);
+	pattern++;
+	
+	return DataBuffer::commitWrite(first.length + second.length);
+}
+
+
 // --- DATA REQUEST FUNCTION ---
 // This function can be signalled with the condition variable to request data from the client.
 void dataRequestFunction() {
@@ -77,8 +91,9 @@ void dataWriteFunction() {
 		}
 	
 		// Write into buffer after a brief delay.
+		// Write the amount of data that was asked for.
 		std::this_thread::sleep_for(std::chrono::milliseconds(1));
-		DataBuffer::write(chunk, chunk_size);
+		writeChunk(DataBuffer::getDataRequestSize());
 	}
 }
 
@@ -90,7 +105,7 @@ void seekingHandler(uint32_t session, int64_t offset) {
 	
 		// Write into buffer after a brief delay.
 		std::this_thread::sleep_for(std::chrono::milliseconds(100));
-		DataBuffer::write(chunk, chunk_size);
+		writeChunk(chunk_size);
 	}
 }
 
@@ -102,12 +117,10 @@ void signal_handler(int signal) {
 
 
 int main() {
-	// Set up buffer.
-	chunk = new char[chunk_size];
-	
 	// Init DataBuffer.
 	uint32_t buffer_size = 1 * (1024 * 1024); // 1 MB
 	DataBuffer::init(buffer_size);
+	DataBuffer::setRequestSize(chunk_size);
 	DataBuffer::setSeekRequestCallback(seekingHandler);
 	
 	// Start the data write handler in its own thread.
@@ -144,7 +157,5 @@ int main() {
 	readThread->join();
 	delete readThread;
 	
-	delete[] chunk;
-	
 	return 0;
 }
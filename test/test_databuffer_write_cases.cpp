@@ -9,6 +9,7 @@
 #include <iterator>
 #include <numeric>
 #include <string>
+#include <vector>
 
 // DataBuffer::write() uses `char *`, not `uint8_t` or `unsigned char *`.
 
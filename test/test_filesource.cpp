@@ -0,0 +1,108 @@
+/*
+	test_filesource.cpp - Tests for the file-backed StreamBuffer producer.
+
+*/
+
+
+#include "../src/filesource.h"
+#include "testpattern.h"
+
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+
+const int64_t fileSize = 8 * 1024 * 1024 + 1234;	// Ends with an unaligned range.
+
+
+// Write the test file.
+
+bool writeFile(std::string const & path)
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (file == 0) { return false; }
+	std::vector<uint8_t> data(fileSize);
+	fillPattern(data.data(), fileSize, 0);
+	bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+	fclose(file);
+	return ok;
+}
+
+// Read 'length' bytes and check them against the pattern at the current position.
+
+bool readPattern(StreamBuffer & sb, uint32_t length)
+{
+	int64_t offset = sb.tell();
+	std::vector<uint8_t> data(length);
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now()
+															+ std::chrono::seconds(5);
+	if (sb.readToEof(length, data.data(), deadline) != length) { return false; }
+	return checkPattern(data.data(), length, offset);
+}
+
+// Stream the whole file, then seek around in it.
+
+void test_source(std::string const & title, std::string const & path, uint32_t capacity,
+					uint32_t depth, bool direct)
+{
+	FileSource source;
+	assert(source.open(path, direct));
+	assert(source.getFileSize() == fileSize);
+	
+	StreamBuffer sb;
+	assert(sb.init(capacity));
+	sb.setRequestSize(64 * 1024);
+	assert(source.start(sb, depth));
+	
+	int64_t left = fileSize;
+	while (left > 0)
+	{
+		uint32_t length = (left < 100000) ? left : 100000;
+		assert(readPattern(sb, length));
+		left -= length;
+	}
+	
+	uint8_t byte;
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now()
+															+ std::chrono::seconds(5);
+	assert(sb.readToEof(1, &byte, deadline) == 0 && sb.isEof());
+	
+	// Seek to aligned and unaligned offsets, and read a little at each.
+	std::mt19937 rng(42);
+	for (int i = 0; i < 20; ++i)
+	{
+		int64_t offset = rng() % (fileSize - 70000);
+		if (i % 2 == 0) { offset &= ~4095LL; }
+		assert(sb.seek(DB_SEEK_START, offset) == offset);
+		assert(readPattern(sb, 70000));
+	}
+	
+	source.stop();
+	assert(source.getError() == 0);
+	std::cout << title << (source.isDirect() ? " (O_DIRECT)" : "") << ": OK\n";
+}
+
+
+int main()
+{
+	std::string path = "filesource_test.bin";
+	assert(writeFile(path));
+	
+	FileSource missing;
+	assert(!missing.open("does/not/exist.bin"));
+	StreamBuffer sb;
+	assert(sb.init(4096));
+	assert(!missing.start(sb, 4));
+	
+	test_source("Depth 1", path, 1024 * 1024, 1, false);
+	test_source("Depth 8", path, 1024 * 1024, 8, false);
+	test_source("Depth 8, unaligned buffer", path, 1000 * 1000, 8, false);
+	test_source("Depth 8, direct", path, 1024 * 1024, 8, true);
+	
+	remove(path.c_str());
+	std::cout << "Done.\n";
+	return 0;
+}
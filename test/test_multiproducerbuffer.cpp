@@ -0,0 +1,136 @@
+/*
+	test_multiproducerbuffer.cpp - Tests for the multiple producer, single consumer buffer.
+
+*/
+
+
+#include "../src/multiproducerbuffer.h"
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+
+// Write a chunk of 'length' bytes filled with 'value'.
+
+bool writeChunk(MultiProducerBuffer & mpb, uint32_t length, uint8_t value)
+{
+	std::vector<char> data(length, (char) value);
+	return mpb.write(data.data(), length);
+}
+
+// Read the next chunk and check its length and contents.
+
+bool readChunk(MultiProducerBuffer & mpb, uint32_t length, uint8_t value)
+{
+	std::vector<uint8_t> data(4096);
+	if (mpb.read(data.size(), data.data()) != length) { return false; }
+	for (uint32_t i = 0; i < length; ++i)
+	{
+		if (data[i] != value)
+			return false;
+	}
+	return true;
+}
+
+
+int main()
+{
+	MultiProducerBuffer mpb;
+	assert(!mpb.init(1000));
+	assert(mpb.init(1024));
+	
+	// Chunks are read in reservation order, whatever the commit order.
+	BufferSpan a, b;
+	assert(mpb.reserve(100, a));
+	assert(mpb.reserve(200, b));
+	memset(a.data, 1, a.length);
+	memset(b.data, 2, b.length);
+	mpb.commitWrite(b);
+	BufferSpan chunk;
+	assert(mpb.peek(chunk) == 0);
+	mpb.commitWrite(a);
+	assert(mpb.peek(chunk) == 100 && chunk.data == a.data);
+	assert(mpb.commit() == 100);
+	assert(readChunk(mpb, 200, 2));
+	assert(mpb.commit() == 0);
+	std::cout << "Reservation order: OK\n";
+	
+	// A chunk that does not fit before the end of the buffer wraps to the front. The reader
+	// skips the padding.
+	assert(writeChunk(mpb, 300, 3));
+	assert(writeChunk(mpb, 200, 4));
+	assert(!writeChunk(mpb, 400, 5));			// Full.
+	assert(readChunk(mpb, 300, 3));
+	assert(writeChunk(mpb, 300, 5));			// Pads the end, then wraps.
+	assert(readChunk(mpb, 200, 4));
+	assert(mpb.peek(chunk) == 300 && chunk.data == a.data);
+	assert(readChunk(mpb, 300, 5));
+	assert(!writeChunk(mpb, 2048, 6));			// Larger than the buffer.
+	
+	// A chunk that only fits at the front of an empty buffer waits for the reader to skip 
+	// the end.
+	MultiProducerBuffer eb;
+	assert(eb.init(1024));
+	assert(writeChunk(eb, 640, 7));
+	assert(readChunk(eb, 640, 7));
+	assert(!writeChunk(eb, 700, 8));			// Pads the end.
+	assert(eb.peek(chunk) == 0);				// Skips the padding.
+	assert(writeChunk(eb, 700, 8));
+	assert(readChunk(eb, 700, 8));
+	std::cout << "Wrap & padding: OK\n";
+	
+	// Concurrent producers. Each chunk carries its producer & sequence number. The reader checks
+	// that each producer's chunks arrive complete and in order.
+	MultiProducerBuffer cb;
+	assert(cb.init(64 * 1024));
+	const uint32_t producers = 4;
+	const uint32_t chunks = 50000;
+	std::vector<std::thread> threads;
+	for (uint32_t p = 0; p < producers; ++p)
+	{
+		threads.push_back(std::thread([&cb, p, chunks] {
+			for (uint32_t seq = 0; seq < chunks; )
+			{
+				uint32_t length = 8 + (seq * 7 + p * 13) % 500;
+				BufferSpan span;
+				if (!cb.reserve(length, span)) { std::this_thread::yield(); continue; }
+				memcpy(span.data, &p, 4);
+				memcpy(span.data + 4, &seq, 4);
+				memset(span.data + 8, (uint8_t) (seq + p), length - 8);
+				cb.commitWrite(span);
+				seq++;
+			}
+		}));
+	}
+	
+	std::vector<uint32_t> expected(producers, 0);
+	uint32_t received = 0;
+	bool ok = true;
+	while (received < producers * chunks)
+	{
+		BufferSpan span;
+		uint32_t length = cb.peek(span);
+		if (length == 0) { std::this_thread::yield(); continue; }
+	
+		uint32_t p, seq;
+		memcpy(&p, span.data, 4);
+		memcpy(&seq, span.data + 4, 4);
+		ok = ok && p < producers && seq == expected[p];
+		ok = ok && length == 8 + (seq * 7 + p * 13) % 500;
+		for (uint32_t i = 8; i < length; ++i)
+			ok = ok && span.data[i] == (uint8_t) (seq + p);
+		if (p < producers) { expected[p] = seq + 1; }
+		cb.commit();
+		received++;
+	}
+	
+	for (std::thread &t : threads) { t.join(); }
+	assert(ok);
+	std::cout << "Concurrent producers: OK\n";
+	
+	std::cout << "Done.\n";
+	return 0;
+}
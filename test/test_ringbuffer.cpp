@@ -0,0 +1,100 @@
+/*
+	test_ringbuffer.cpp - Tests for the RingBuffer template.
+
+*/
+
+
+#include "../src/ringbuffer.h"
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+
+static_assert(RingBuffer<uint64_t, 1024>::capacity() == 1024, "Capacity is a compile-time constant.");
+static_assert(RingBuffer<uint32_t, 16>::storageSize() == 64, "Storage size is a compile-time constant.");
+static_assert(RingBuffer<uint8_t, 8>::index(13) == 5, "Indices are masked.");
+
+
+struct Sample {
+	uint32_t id;
+	float value;
+};
+
+
+int main()
+{
+	// Single elements, including the wrap at the end of the ring.
+	RingBuffer<Sample, 8> rb;
+	Sample s;
+	assert(!rb.pop(s));
+	for (uint32_t round = 0; round < 3; ++round)
+	{
+		for (uint32_t i = 0; i < 8; ++i)
+			assert(rb.push(Sample { round * 8 + i, 0.5f }));
+		assert(!rb.push(Sample { 0, 0 }));			// Full.
+		assert(rb.readable() == 8 && rb.writable() == 0);
+		for (uint32_t i = 0; i < 8; ++i)
+			assert(rb.pop(s) && s.id == round * 8 + i && s.value == 0.5f);
+		assert(!rb.pop(s));
+	}
+	std::cout << "Push & pop: OK\n";
+	
+	// Bulk copies and spans across the wrap.
+	RingBuffer<uint32_t, 16> ib;
+	uint32_t in[20], out[20];
+	for (uint32_t i = 0; i < 20; ++i) { in[i] = i; }
+	assert(ib.write(in, 10) == 10);
+	assert(ib.read(out, 10) == 10 && memcmp(in, out, 10 * sizeof(uint32_t)) == 0);
+	assert(ib.write(in, 20) == 16);			// Limited to the free space.
+	assert(ib.read(out, 20) == 16 && memcmp(in, out, 16 * sizeof(uint32_t)) == 0);
+	
+	RingBuffer<uint32_t, 16>::Span first, second;
+	assert(ib.write(in, 2) == 2);
+	assert(ib.read(out, 2) == 2);
+	assert(ib.reserve(12, first, second) == 12);
+	assert(first.length == 4 && second.length == 8);
+	for (uint32_t i = 0; i < first.length; ++i) { first.data[i] = 100 + i; }
+	for (uint32_t i = 0; i < second.length; ++i) { second.data[i] = 104 + i; }
+	assert(ib.commitWrite(12) == 12);
+	assert(ib.peek(first, second) == 12);
+	assert(first.length == 4 && second.length == 8);
+	assert(first.data[0] == 100 && second.data[7] == 111);
+	assert(ib.commit(5) == 5);
+	assert(ib.peek(first, second) == 7 && first.length == 7 && second.length == 0);
+	assert(first.data[0] == 105);
+	assert(ib.commit(20) == 7);			// Limited to the unread elements.
+	std::cout << "Spans: OK\n";
+	
+	// One writer & one reader thread. The reader checks the sequence.
+	typedef RingBuffer<uint64_t, 1024> SequenceBuffer;
+	std::unique_ptr<SequenceBuffer> sb(new SequenceBuffer);
+	const uint64_t count = 2000000;
+	std::thread writer([&sb, count] {
+		uint64_t batch[37];
+		for (uint64_t next = 0; next < count; )
+		{
+			uint32_t n = 0;
+			while (n < 37 && next + n < count) { batch[n] = next + n; n++; }
+			next += sb->write(batch, n);
+		}
+	});
+	
+	bool ok = true;
+	uint64_t expected = 0;
+	while (expected < count)
+	{
+		uint64_t value;
+		if (!sb->pop(value)) { std::this_thread::yield(); continue; }
+		ok = ok && value == expected;
+		expected++;
+	}
+	writer.join();
+	assert(ok);
+	std::cout << "Concurrent sequence: OK\n";
+	
+	std::cout << "Done.\n";
+	return 0;
+}
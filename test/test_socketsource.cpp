@@ -0,0 +1,123 @@
+/*
+	test_socketsource.cpp - Tests for the socket-backed StreamBuffer producer, over loopback.
+
+*/
+
+
+#include "../src/socketsource.h"
+#include "testpattern.h"
+
+#include <arpa/inet.h>
+#include <cassert>
+#include <iostream>
+#include <netinet/in.h>
+#include <random>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+
+const uint32_t streamSize = 4 * 1024 * 1024;
+
+
+// Send the pattern in chunks of random size, then shut down the connection.
+
+void sender(int fd)
+{
+	std::vector<uint8_t> data(streamSize);
+	fillPattern(data.data(), streamSize, 0);
+	std::mt19937 rng(7);
+	uint32_t sent = 0;
+	while (sent < streamSize)
+	{
+		uint32_t length = 1 + rng() % 20000;
+		if (length > streamSize - sent) { length = streamSize - sent; }
+		ssize_t n = send(fd, data.data() + sent, length, MSG_NOSIGNAL);
+		assert(n > 0);
+		sent += n;
+	}
+	
+	shutdown(fd, SHUT_WR);
+}
+
+// Read the stream through a small buffer, so that the sender is held up, and check it.
+
+void test_stream(std::string const & title, int sendFd, int recvFd)
+{
+	StreamBuffer sb;
+	assert(sb.init(64 * 1024));
+	SocketSource source;
+	assert(source.start(sb, recvFd));
+	assert(!source.start(sb, recvFd));		// Already running.
+	
+	std::thread writer(sender, sendFd);
+	std::vector<uint8_t> data(10000);
+	uint32_t received = 0;
+	bool ok = true;
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() 
+															+ std::chrono::seconds(20);
+	for (;;)
+	{
+		uint32_t n = sb.readAtLeast(1, data.size(), data.data(), deadline);
+		if (n == 0) { break; }
+		ok = ok && checkPattern(data.data(), n, received);
+		received += n;
+	}
+	
+	writer.join();
+	assert(ok);
+	assert(received == streamSize);
+	assert(sb.isEof());
+	source.stop();
+	assert(!source.isRunning() && source.getError() == 0);
+	close(sendFd);
+	close(recvFd);
+	
+	std::cout << title << ": OK\n";
+}
+
+
+int main()
+{
+	int fds[2];
+	assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+	test_stream("Unix domain socket", fds[0], fds[1]);
+	
+	// TCP over loopback.
+	int listener = socket(AF_INET, SOCK_STREAM, 0);
+	assert(listener >= 0);
+	sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = 0;
+	assert(bind(listener, (sockaddr*) &addr, sizeof(addr)) == 0);
+	assert(listen(listener, 1) == 0);
+	socklen_t len = sizeof(addr);
+	assert(getsockname(listener, (sockaddr*) &addr, &len) == 0);
+	
+	int client = socket(AF_INET, SOCK_STREAM, 0);
+	assert(connect(client, (sockaddr*) &addr, sizeof(addr)) == 0);
+	int server = accept(listener, 0, 0);
+	assert(server >= 0);
+	close(listener);
+	test_stream("TCP loopback", client, server);
+	
+	// Stopping while the peer is idle.
+	assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+	StreamBuffer sb;
+	assert(sb.init(4096));
+	SocketSource source;
+	assert(source.start(sb, fds[1]));
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	assert(source.isRunning());
+	source.stop();
+	assert(!sb.isEof());
+	close(fds[0]);
+	close(fds[1]);
+	std::cout << "Stop: OK\n";
+	
+	std::cout << "Done.\n";
+	return 0;
+}
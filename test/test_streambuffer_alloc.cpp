@@ -0,0 +1,88 @@
+/*
+	test_streambuffer_alloc.cpp - Tests for the StreamBuffer allocation options.
+
+*/
+
+
+#include "../src/streambuffer.h"
+
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+// Stream a few times the capacity through the buffer and check the data.
+
+bool roundTrip(StreamBuffer & sb, uint32_t capacity)
+{
+	std::vector<char> in(capacity / 3);
+	std::vector<uint8_t> out(in.size());
+	uint8_t value = 0;
+	for (int i = 0; i < 10; ++i)
+	{
+		for (size_t j = 0; j < in.size(); ++j) { in[j] = (char) (value + j); }
+		if (sb.write(in.data(), in.size()) != in.size()) { return false; }
+		if (sb.read(out.size(), out.data()) != out.size()) { return false; }
+		for (size_t j = 0; j < out.size(); ++j)
+		{
+			if (out[j] != (uint8_t) (value + j))
+				return false;
+		}
+		value++;
+	}
+	return true;
+}
+
+// Initialise with the given options. Options the system does not allow for may be left out, 
+// but the buffer must work either way.
+
+void test_alloc(std::string const & title, uint32_t capacity, uint32_t flags)
+{
+	StreamBuffer sb;
+	sb.setAllocation(flags);
+	assert(sb.init(capacity));
+	sb.setEof(true);	// No data requests.
+	
+	uint32_t applied = sb.getAllocation();
+	assert((applied & ~flags) == 0);
+	assert((applied & DB_ALLOC_PREFAULT) == (flags & DB_ALLOC_PREFAULT));
+	assert(roundTrip(sb, capacity));
+	
+	std::cout << title << (sb.isMirrored() ? " (mirrored)" : "") << ": requested " << flags 
+				<< ", applied " << applied << ": OK\n";
+}
+
+
+int main()
+{
+	const uint32_t mirrored = 4 * 1024 * 1024;
+	const uint32_t plain = 4 * 1000 * 1000 + 1;
+	uint32_t options[] = {
+		DB_ALLOC_DEFAULT,
+		DB_ALLOC_HUGE_PAGES | DB_ALLOC_PREFAULT,
+		DB_ALLOC_HUGETLB,
+		DB_ALLOC_NUMA | DB_ALLOC_PREFAULT,
+		DB_ALLOC_PREFAULT | DB_ALLOC_LOCK,
+		DB_ALLOC_HUGE_PAGES | DB_ALLOC_NUMA | DB_ALLOC_PREFAULT | DB_ALLOC_LOCK
+	};
+	
+	for (uint32_t flags : options)
+	{
+		test_alloc("Page-aligned buffer", mirrored, flags);
+		test_alloc("Unaligned buffer", plain, flags);
+	}
+	
+	// Re-initialising releases the old mapping and applies the new options.
+	StreamBuffer sb;
+	sb.setAllocation(DB_ALLOC_PREFAULT);
+	assert(sb.init(plain));
+	assert(sb.getAllocation() == DB_ALLOC_PREFAULT);
+	sb.setAllocation(DB_ALLOC_DEFAULT);
+	assert(sb.init(plain));
+	assert(sb.getAllocation() == 0);
+	std::cout << "Re-init: OK\n";
+	
+	std::cout << "Done.\n";
+	return 0;
+}
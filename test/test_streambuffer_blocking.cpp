@@ -0,0 +1,123 @@
+/*
+	test_streambuffer_blocking.cpp - Tests for the blocking StreamBuffer reads & wait strategies.
+	
+*/
+
+
+#include "../src/streambuffer.h"
+
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+StreamBuffer* sbp;
+std::condition_variable dataRequestCv;
+std::mutex dataRequestMtx;
+std::atomic<bool> running = { true };
+uint8_t pattern = 0;
+const uint32_t totalSize = 1024 * 1024;
+uint32_t produced = 0;
+
+
+// --- DATA REQUEST FUNCTION ---
+// Serve data requests with the requested number of bytes, after a brief delay.
+void dataRequestFunction() {
+	StreamBuffer& sb = *sbp;
+	while (running) {
+		std::unique_lock<std::mutex> lk(dataRequestMtx);
+		dataRequestCv.wait_for(lk, std::chrono::milliseconds(1));
+		if (!sb.dataRequestPending) { continue; }
+		
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		uint32_t size = sb.getDataRequestSize();
+		if (size > totalSize - produced) { size = totalSize - produced; }
+		std::vector<char> data(size);
+		for (uint32_t i = 0; i < size; ++i) { data[i] = (char) pattern++; }
+		produced += sb.write(data.data(), size);
+		if (produced == totalSize) { sb.setEof(true); }
+	}
+}
+
+
+// Check that the data continues the written pattern.
+
+bool check(std::vector<uint8_t> const & data, uint32_t length, uint8_t & expected)
+{
+	for (uint32_t i = 0; i < length; ++i)
+	{
+		if (data[i] != expected++)
+			return false;
+	}
+	return true;
+}
+
+
+// Run the blocking reads against a writer thread, using the given wait strategy.
+
+void test_blocking(std::string const & title, DataBufferWait strategy)
+{
+	using namespace std::chrono;
+	
+	std::cout << title << "\n";
+	StreamBuffer sb(strategy);
+	sbp = &sb;
+	pattern = 0;
+	produced = 0;
+	running = true;
+	
+	assert(sb.init(64 * 1024));
+	sb.setRequestSize(16 * 1024);
+	sb.setDataRequestCondition(&dataRequestCv);
+	
+	// Nothing is written until the first request, so a short deadline times out.
+	std::vector<uint8_t> data(totalSize);
+	steady_clock::time_point begin = steady_clock::now();
+	assert(sb.readExact(1024, data.data(), begin + milliseconds(1)) == 0);
+	assert(steady_clock::now() - begin >= milliseconds(1));
+	std::cout << "Time-out: OK\n";
+	
+	std::thread drq(dataRequestFunction);
+	uint8_t expected = 0;
+	
+	// The blocking reads start data requests themselves and are woken by the writer.
+	assert(sb.readExact(32 * 1024, data.data(), steady_clock::now() + seconds(5)) == 32 * 1024);
+	assert(check(data, 32 * 1024, expected));
+	std::cout << "Exact read: OK\n";
+	
+	// Reading more than the buffer capacity.
+	uint32_t bytesRead = sb.readAtLeast(200 * 1024, 256 * 1024, data.data(), 
+														steady_clock::now() + seconds(5));
+	assert(bytesRead >= 200 * 1024 && bytesRead <= 256 * 1024);
+	assert(check(data, bytesRead, expected));
+	std::cout << "Read at least: " << bytesRead << " bytes, OK\n";
+	
+	// Read the rest of the stream.
+	uint32_t remaining = totalSize - 32 * 1024 - bytesRead;
+	bytesRead = sb.readToEof(totalSize, data.data(), steady_clock::now() + seconds(10));
+	std::cout << "Read to EOF: " << bytesRead << " bytes\n";
+	assert(bytesRead == remaining);
+	assert(sb.isEof());
+	assert(check(data, bytesRead, expected));
+	
+	// At EOF the blocking reads return right away.
+	assert(sb.readExact(1, data.data(), steady_clock::now() + seconds(10)) == 0);
+	assert(sb.readAtLeast(1, 1, data.data(), steady_clock::now() + seconds(10)) == 0);
+	
+	running = false;
+	drq.join();
+}
+
+
+int main()
+{
+	test_blocking("Condition variable:", DB_WAIT_CONDITION);
+	test_blocking("Spin:", DB_WAIT_SPIN);
+	test_blocking("Spin, then yield:", DB_WAIT_SPIN_YIELD);
+	test_blocking("Futex:", DB_WAIT_FUTEX);
+	
+	std::cout << "Done.\n";
+	return 0;
+}
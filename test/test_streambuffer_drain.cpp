@@ -0,0 +1,95 @@
+/*
+	test_streambuffer_drain.cpp - Tests for draining a StreamBuffer to a file descriptor.
+
+*/
+
+
+#include "../src/streambuffer.h"
+
+#include <cassert>
+#include <cerrno>
+#include <fcntl.h>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+
+// Write a sequence through the buffer and drain it to one end of a socket pair, with the unread 
+// section wrapping around. Check that the other end receives the sequence in order.
+
+void test_drain(std::string const & title, uint32_t capacity)
+{
+	StreamBuffer sb;
+	assert(sb.init(capacity));
+	sb.setEof(true);	// No data requests.
+	
+	int fds[2];
+	assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+	
+	std::vector<uint8_t> in(capacity * 5 + 3);
+	std::iota(in.begin(), in.end(), 0);
+	std::vector<uint8_t> out(in.size());
+	uint32_t written = 0;
+	uint32_t received = 0;
+	while (received < in.size())
+	{
+		written += sb.write((const char*) in.data() + written, in.size() - written);
+		assert(sb.drain(fds[0], capacity / 2 + 1) >= 0);
+		
+		ssize_t n = recv(fds[1], out.data() + received, out.size() - received, MSG_DONTWAIT);
+		if (n > 0) { received += n; }
+	}
+	
+	assert(out == in);
+	assert(sb.drain(fds[0]) == 0);			// Nothing left.
+	close(fds[0]);
+	close(fds[1]);
+	
+	std::cout << title << (sb.isMirrored() ? " (mirrored)" : "") << ": OK\n";
+}
+
+
+int main()
+{
+	test_drain("Drain", 1001);
+	test_drain("Drain", 4096);
+	
+	// A full non-blocking pipe takes part of the data. The rest stays unread.
+	StreamBuffer sb;
+	assert(sb.init(1024 * 1024));
+	sb.setEof(true);
+	int fds[2];
+	assert(pipe(fds) == 0);
+	assert(fcntl(fds[1], F_SETFL, O_NONBLOCK) == 0);
+	int pipeSize = fcntl(fds[1], F_GETPIPE_SZ);
+	assert(pipeSize > 0 && pipeSize < 512 * 1024);
+	
+	std::vector<char> data(512 * 1024, 'x');
+	assert(sb.write(data.data(), data.size()) == data.size());
+	assert(sb.drain(fds[1]) == pipeSize);
+	assert(sb.tell() == pipeSize);
+	assert(sb.drain(fds[1]) == -1 && errno == EAGAIN);
+	assert(sb.tell() == pipeSize);
+	
+	// An invalid descriptor fails without committing anything.
+	close(fds[0]);
+	close(fds[1]);
+	assert(sb.drain(fds[1]) == -1 && errno == EBADF);
+	BufferSpan first, second;
+	assert(sb.peek(first, second) == data.size() - pipeSize);
+	std::cout << "Partial drain: OK\n";
+	
+	// A socket whose peer is gone fails with EPIPE, without raising SIGPIPE.
+	assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+	close(fds[1]);
+	assert(sb.drain(fds[0]) == -1 && errno == EPIPE);
+	assert(sb.peek(first, second) == data.size() - pipeSize);
+	close(fds[0]);
+	std::cout << "Closed peer: OK\n";
+	
+	std::cout << "Done.\n";
+	return 0;
+}
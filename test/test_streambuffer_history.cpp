@@ -0,0 +1,80 @@
+/*
+	test_streambuffer_history.cpp - Tests for local seeking within the StreamBuffer.
+	
+*/
+
+
+#include "../src/streambuffer.h"
+#include "testpattern.h"
+
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+
+StreamBuffer sb;
+uint32_t seekRequests = 0;
+
+
+// Seek handler, serving the data from the requested offset.
+
+void seekingHandler(uint32_t, int64_t offset)
+{
+	seekRequests++;
+	writePattern(sb, offset, 4096);
+}
+
+
+int main()
+{
+	const uint32_t capacity = 64 * 1024;
+	assert(sb.init(capacity));
+	sb.setRequestSize(8 * 1024);
+	sb.setHistorySize(16 * 1024);
+	sb.setFileSize(1024 * 1024);
+	sb.setSeekRequestCallback(seekingHandler);
+	
+	// Stream 40 kB, consume 30 kB of it.
+	assert(writePattern(sb, 0, 40 * 1024) == 40 * 1024);
+	assert(readPattern(sb, 0, 30 * 1024));
+	
+	// The writer may not overwrite the history: 10 kB unread, 16 kB history.
+	BufferSpan first, second;
+	assert(sb.reserve(capacity, first, second) == capacity - (10 + 16) * 1024);
+	
+	// Seeking back within the history is served locally.
+	assert(sb.seek(DB_SEEK_START, 20 * 1024) == 20 * 1024);
+	assert(seekRequests == 0);
+	assert(readPattern(sb, 20 * 1024, 12 * 1024));
+	assert(sb.seek(DB_SEEK_CURRENT, -16 * 1024) == 16 * 1024);
+	assert(seekRequests == 0);
+	assert(readPattern(sb, 16 * 1024, 24 * 1024));
+	std::cout << "Seek within history: OK\n";
+	
+	// Skipping and seeking forward within the unread data is served locally.
+	assert(writePattern(sb, 40 * 1024, 8 * 1024) == 8 * 1024);
+	assert(sb.skip(1024) == 1024);
+	assert(readPattern(sb, 41 * 1024, 1024));
+	assert(sb.seek(DB_SEEK_CURRENT, 2048) == 44 * 1024);
+	assert(readPattern(sb, 44 * 1024, 1024));
+	assert(sb.seek(DB_SEEK_START, 48 * 1024) == 48 * 1024);
+	assert(seekRequests == 0);
+	assert(sb.skip(1) == 0);
+	std::cout << "Skip within unread data: OK\n";
+	
+	// Seeking back past the history goes to the client.
+	assert(sb.seek(DB_SEEK_START, 1024) == 1024);
+	assert(seekRequests == 1);
+	assert(readPattern(sb, 1024, 4096));
+	std::cout << "Seek past history: OK\n";
+	
+	// The history is limited to leave room for a request block.
+	sb.setHistorySize(capacity);
+	assert(writePattern(sb, 5120, capacity - 4096) == capacity - 4096);
+	assert(readPattern(sb, 5120, capacity - 4096));
+	assert(sb.reserve(capacity, first, second) == 8 * 1024);
+	std::cout << "History limit: OK\n";
+	
+	std::cout << "Done.\n";
+	return 0;
+}
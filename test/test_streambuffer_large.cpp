@@ -0,0 +1,102 @@
+/*
+	test_streambuffer_large.cpp - Streams past the 4 GiB boundary through a StreamBuffer.
+	
+*/
+
+
+#include "../src/streambuffer.h"
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+
+const uint32_t block = 64 * 1024;
+const int64_t limit = 4LL * 1024 * 1024 * 1024;	// 4 GiB.
+
+StreamBuffer sb;
+int64_t producerOffset = 0;
+
+
+// Synthetic producer: each block starts with its 64-bit stream offset.
+
+void produce(uint32_t length)
+{
+	BufferSpan first, second;
+	sb.reserve(length, first, second);
+	assert(second.length == 0);		// Mirrored buffer, blocks never wrap.
+	memcpy(first.data, &producerOffset, sizeof(producerOffset));
+	producerOffset += sb.commitWrite(first.length);
+}
+
+// Seek handler, restarting the producer at the requested offset.
+
+void seekingHandler(uint32_t, int64_t offset)
+{
+	producerOffset = offset;
+	produce(block);
+}
+
+// Read one block and check that it starts at the expected stream offset.
+
+void consume(int64_t expected)
+{
+	std::vector<uint8_t> data(block);
+	assert(sb.tell() == expected);
+	assert(sb.read(block, data.data()) == block);
+	
+	int64_t offset;
+	memcpy(&offset, data.data(), sizeof(offset));
+	assert(offset == expected);
+}
+
+// Check the next block in place and skip over it.
+
+void check(int64_t expected)
+{
+	BufferSpan first, second;
+	assert(sb.tell() == expected);
+	assert(sb.peek(first, second) >= block);
+	
+	int64_t offset;
+	memcpy(&offset, first.data, sizeof(offset));
+	assert(offset == expected);
+	assert(sb.skip(block) == block);
+}
+
+
+int main()
+{
+	assert(sb.init(16 * block));
+	assert(sb.isMirrored());
+	sb.setFileSize(limit + 1024 * 1024 * 1024);
+	sb.setHistorySize(4 * block);
+	sb.setSeekRequestCallback(seekingHandler);
+	
+	// Stream from the start to past the 4 GiB boundary.
+	int64_t expected = 0;
+	while (expected < limit + 16 * block) {
+		produce(block);
+		check(expected);
+		expected += block;
+	}
+	
+	std::cout << "Streamed to " << sb.tell() << " bytes.\n";
+	assert(sb.tell() > limit);
+	
+	// Seek back across the boundary, within the history.
+	assert(sb.seek(DB_SEEK_START, limit + 14 * block) == limit + 14 * block);
+	consume(limit + 14 * block);
+	
+	// Seek through the client to positions on both sides of the boundary.
+	assert(sb.seek(DB_SEEK_START, limit - block) == limit - block);
+	produce(block);
+	consume(limit - block);
+	consume(limit);
+	assert(sb.seek(DB_SEEK_END, 1024 * 1024 * 1024 - 1) == limit);
+	consume(limit);
+	
+	std::cout << "Done.\n";
+	return 0;
+}
@@ -0,0 +1,161 @@
+/*
+	test_streambuffer_producer.cpp - Tests for the pull-mode StreamBuffer producer.
+
+*/
+
+
+#include "../src/streambuffer.h"
+#include "testpattern.h"
+
+#include <atomic>
+#include <cassert>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+const int64_t fileSize = 1024 * 1024;
+std::atomic<uint32_t> calls = { 0 };
+
+
+// Producer: write the test pattern for the requested offsets straight into the buffer. The 
+// buffer sets EOF once the file size is reached.
+
+uint32_t produce(int64_t offset, uint32_t size, BufferSpan & first, BufferSpan & second)
+{
+	calls++;
+	if (offset + size > fileSize) { size = fileSize - offset; }
+	uint32_t single = (first.length < size) ? first.length : size;
+	uint32_t rest = (second.length < size - single) ? second.length : size - single;
+	fillPattern(first.data, single, offset);
+	fillPattern(second.data, rest, offset + single);
+	return single + rest;
+}
+
+// Executor running tasks on a worker thread of its own.
+
+class Worker
+{
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::deque<std::function<void()>> tasks;
+	bool running = true;
+	std::thread thread;
+
+public:
+	std::atomic<uint32_t> posted = { 0 };
+
+	Worker() : thread([this] { run(); }) { }
+
+	~Worker()
+	{
+		{
+			std::lock_guard<std::mutex> lk(mutex);
+			running = false;
+		}
+		cv.notify_one();
+		thread.join();
+	}
+
+	void post(std::function<void()> task)
+	{
+		posted++;
+		{
+			std::lock_guard<std::mutex> lk(mutex);
+			tasks.push_back(task);
+		}
+		cv.notify_one();
+	}
+
+	void run()
+	{
+		std::unique_lock<std::mutex> lk(mutex);
+		while (running || !tasks.empty())
+		{
+			if (tasks.empty()) { cv.wait(lk); continue; }
+			std::function<void()> task = tasks.front();
+			tasks.pop_front();
+			lk.unlock();
+			task();
+			lk.lock();
+		}
+	}
+};
+
+// Read the file from 'offset' to the end and check it against the pattern.
+
+bool readToEnd(StreamBuffer & sb, int64_t offset)
+{
+	uint32_t length = fileSize - offset;
+	std::vector<uint8_t> data(length);
+	std::chrono::steady_clock::time_point deadline = 
+								std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	if (sb.readToEof(length, data.data(), deadline) != length) { return false; }
+
+	// EOF follows the last data.
+	uint8_t byte;
+	if (sb.readToEof(1, &byte, deadline) != 0 || !sb.isEof()) { return false; }
+	return checkPattern(data.data(), length, offset);
+}
+
+// Stream the file, then seek back and stream the rest again.
+
+void test_producer(std::string const & title, RefillExecutor executor)
+{
+	StreamBuffer sb;
+	assert(sb.init(64 * 1024));
+	sb.setFileSize(fileSize);
+	sb.setRequestSize(16 * 1024);
+	sb.setProducer(produce, executor);
+	assert(sb.start());
+	assert(readToEnd(sb, 0));
+
+	// Seeks are served by the producer as well, no seek handler is needed.
+	assert(sb.seek(DB_SEEK_START, 300000) == 300000);
+	assert(sb.tell() == 300000);
+	assert(readToEnd(sb, 300000));
+
+	sb.setProducer(nullptr);
+	sb.cleanup();
+	std::cout << title << ": OK\n";
+}
+
+
+int main()
+{
+	test_producer("Refill thread", nullptr);
+	assert(calls > 0);
+
+	Worker worker;
+	test_producer("Executor", [&worker](std::function<void()> task) { worker.post(task); });
+	assert(worker.posted > 0);
+
+	// An inline executor calls the producer on the reader's thread.
+	calls = 0;
+	test_producer("Inline executor", [](std::function<void()> task) { task(); });
+	assert(calls > 0);
+
+	// A task still queued on the executor when the producer is removed returns without 
+	// calling it. Removing the producer waits for that task.
+	std::vector<std::function<void()>> held;
+	std::unique_ptr<StreamBuffer> sb(new StreamBuffer);
+	assert(sb->init(64 * 1024));
+	sb->setFileSize(fileSize);
+	sb->setProducer(produce, [&held](std::function<void()> task) { held.push_back(task); });
+	assert(sb->start());
+	assert(held.size() == 1);
+	std::atomic<bool> stopped = { false };
+	std::thread stopper([&sb, &stopped] { sb->setProducer(nullptr); stopped = true; });
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	assert(!stopped);
+	held[0]();
+	stopper.join();
+	sb.reset();
+	std::cout << "Queued task: OK\n";
+
+	std::cout << "Done.\n";
+	return 0;
+}
@@ -0,0 +1,211 @@
+/*
+	test_streambuffer_ranges.cpp - Tests for pipelined StreamBuffer range requests.
+
+*/
+
+
+#include "../src/streambuffer.h"
+#include "testpattern.h"
+
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+
+StreamBuffer sb;
+std::condition_variable dataRequestCv;
+std::mutex dataRequestMtx;
+std::atomic<bool> running = { true };
+const uint32_t fileSize = 1024 * 1024;
+
+
+// Seek handler. In range request mode the data is requested as ranges, nothing to do here.
+
+void seekingHandler(uint32_t, int64_t)
+{
+}
+
+// Fetch a range: write the test pattern for its offsets into its slot.
+
+uint32_t fetch(RangeRequest const & request, uint32_t length)
+{
+	BufferSpan first, second;
+	if (sb.reserveRange(request, first, second) == 0) { return sb.completeRange(request, 0); }
+	fillPattern(first.data, first.length, request.offset);
+	fillPattern(second.data, second.length, request.offset + first.length);
+	return sb.completeRange(request, length);
+}
+
+// Producer thread, fetching ranges after a random delay, like a connection of its own.
+
+void producer(unsigned seed)
+{
+	std::mt19937 rng(seed);
+	while (running)
+	{
+		RangeRequest request;
+		if (!sb.nextRange(request))
+		{
+			std::unique_lock<std::mutex> lk(dataRequestMtx);
+			dataRequestCv.wait_for(lk, std::chrono::milliseconds(1));
+			continue;
+		}
+
+		std::this_thread::sleep_for(std::chrono::microseconds(rng() % 500));
+		fetch(request, request.length);
+	}
+}
+
+
+int main()
+{
+	assert(sb.init(64 * 1024));
+	sb.setFileSize(fileSize);
+	sb.setSeekRequestCallback(seekingHandler);
+	sb.setDataRequestCondition(&dataRequestCv);
+	sb.setRequestSize(4096);
+	sb.setWatermarks(8192, UINT32_MAX);
+	sb.setRangeRequests(4);
+
+	// Several ranges are outstanding at once, for consecutive offsets.
+	assert(sb.start());
+	RangeRequest r[4];
+	for (int i = 0; i < 4; ++i)
+	{
+		assert(sb.nextRange(r[i]));
+		assert(r[i].offset == i * 4096 && r[i].length == 4096);
+	}
+
+	RangeRequest extra;
+	assert(!sb.nextRange(extra));
+
+	// Ranges that complete out of order are published in offset order.
+	uint8_t byte;
+	assert(fetch(r[2], 4096) == 4096);
+	assert(fetch(r[1], 4096) == 4096);
+	assert(fetch(r[3], 4096) == 4096);
+	assert(sb.read(1, &byte) == 0);
+	assert(fetch(r[0], 4096) == 4096);
+	assert(readPattern(sb, 0, 16384));
+	std::cout << "Out of order completion: OK\n";
+
+	// The completions requested the next ranges. A short range gets the rest requested again.
+	for (int i = 0; i < 4; ++i)
+	{
+		assert(sb.nextRange(r[i]));
+		assert(r[i].offset == 16384 + i * 4096);
+	}
+
+	assert(fetch(r[0], 1000) == 1000);
+	assert(sb.nextRange(extra));
+	assert(extra.offset == 16384 + 1000 && extra.length == 3096);
+	assert(fetch(r[1], 4096) == 4096);
+	assert(readPattern(sb, 16384, 1000));
+	assert(sb.read(1, &byte) == 0);
+	assert(fetch(extra, 3096) == 3096);
+	assert(readPattern(sb, 17384, 3096 + 4096));
+	std::cout << "Short range: OK\n";
+
+	// After a seek, ranges in flight for the old position are discarded, and the new ranges
+	// start at the seek offset.
+	std::shared_future<int64_t> seek = sb.seekAsync(DB_SEEK_START, 500000);
+	assert(fetch(r[2], 4096) == 0);
+	RangeRequest s;
+	assert(sb.nextRange(s));
+	assert(s.offset == 500000 && s.generation != r[3].generation);
+	assert(fetch(s, 4096) == 4096);
+	assert(seek.get() == 500000);
+	assert(fetch(r[3], 4096) == 0);
+	assert(readPattern(sb, 500000, 4096));
+	std::cout << "Seek with ranges in flight: OK\n";
+
+	// Stream to the end with several producers completing ranges in random order.
+	std::vector<std::thread> producers;
+	for (unsigned i = 0; i < 4; ++i) { producers.push_back(std::thread(producer, i)); }
+
+	std::vector<uint8_t> data(fileSize);
+	uint32_t length = fileSize - 504096;
+	uint32_t n = sb.readToEof(length, data.data(),
+								std::chrono::steady_clock::now() + std::chrono::seconds(30));
+	assert(n == length);
+	assert(checkPattern(data.data(), length, 504096));
+
+	// EOF is set once the last range is published.
+	assert(sb.readToEof(1, &byte, std::chrono::steady_clock::now() + std::chrono::seconds(10)) == 0);
+	assert(sb.isEof());
+
+	running = false;
+	for (std::thread &t : producers) { t.join(); }
+	std::cout << "Parallel producers: OK\n";
+
+	// A range that ends the data sets EOF once it is published, and the rest is not requested 
+	// again. A range that ends after a seek is out of date, and does not set EOF.
+	StreamBuffer eb;
+	assert(eb.init(64 * 1024));
+	eb.setFileSize(fileSize);
+	eb.setSeekRequestCallback(seekingHandler);
+	eb.setDataRequestCondition(&dataRequestCv);
+	eb.setRequestSize(4096);
+	eb.setRangeRequests(2);
+	assert(eb.start());
+	assert(eb.nextRange(r[0]) && eb.nextRange(r[1]));
+	std::shared_future<int64_t> reload = eb.seekAsync(DB_SEEK_START, 100000);
+	BufferSpan first, second;
+	assert(eb.reserveRange(r[1], first, second) == 0);
+	assert(eb.completeRange(r[1], 0, true) == 0);
+	assert(!eb.isEof());
+
+	assert(eb.nextRange(r[2]) && eb.nextRange(r[3]));
+	assert(r[2].offset == 100000 && r[3].offset == 104096);
+	assert(eb.reserveRange(r[3], first, second) == 4096);
+	fillPattern(first.data, first.length, r[3].offset);
+	assert(eb.completeRange(r[3], 100, true) == 100);
+	assert(!eb.isEof());					// Waits for the range before it.
+	assert(eb.reserveRange(r[2], first, second) == 4096);
+	fillPattern(first.data, first.length, r[2].offset);
+	assert(eb.completeRange(r[2], 4096) == 4096);
+	assert(eb.isEof());
+	assert(reload.get() == 100000);
+	assert(!eb.nextRange(extra));
+	assert(readPattern(eb, 100000, 4196));
+	assert(eb.read(1, &byte) == 0);
+	std::cout << "End of data: OK\n";
+
+	// Ranges in flight across a seek or reset hold their slots until they complete. Then the 
+	// ranges of the new generation are issued.
+	StreamBuffer fb;
+	assert(fb.init(16 * 1024));
+	fb.setFileSize(fileSize);
+	fb.setSeekRequestCallback(seekingHandler);
+	fb.setDataRequestCondition(&dataRequestCv);
+	fb.setRequestSize(4096);
+	fb.setRangeRequests(4);
+	assert(fb.start());
+	for (int i = 0; i < 4; ++i) { assert(fb.nextRange(r[i])); }
+	assert(fb.reserveRange(r[0], first, second) == 4096);
+	assert(fb.reset());
+	for (int i = 0; i < 4; ++i) { assert(fb.completeRange(r[i], 4096) == 0); }
+	assert(fb.start());
+	for (int i = 0; i < 4; ++i)
+	{
+		assert(fb.nextRange(r[i]));
+		assert(r[i].offset == i * 4096);
+	}
+
+	std::shared_future<int64_t> moved = fb.seekAsync(DB_SEEK_START, 200000);
+	assert(!fb.nextRange(extra));			// The whole buffer is still reserved.
+	for (int i = 0; i < 4; ++i) { assert(fb.completeRange(r[i], 0) == 0); }
+	assert(fb.nextRange(extra) && extra.offset == 200000);
+	BufferSpan slot, wrap;
+	assert(fb.reserveRange(extra, slot, wrap) == 4096);
+	fillPattern(slot.data, slot.length, extra.offset);
+	assert(fb.completeRange(extra, 4096) == 4096);
+	assert(moved.get() == 200000);
+	assert(readPattern(fb, 200000, 4096));
+	std::cout << "Ranges across a seek: OK\n";
+
+	std::cout << "Done.\n";
+	return 0;
+}
@@ -0,0 +1,122 @@
+/*
+	test_streambuffer_records.cpp - Tests for the StreamBuffer record mode.
+
+*/
+
+
+#include "../src/streambuffer.h"
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Write a record of 'length' bytes, each set to 'value'.
+
+uint32_t writeRecord(StreamBuffer & sb, uint32_t length, uint8_t value)
+{
+	std::vector<char> data(length, (char) value);
+	return sb.writeRecord(data.data(), length);
+}
+
+// Read the next record and check its length and contents.
+
+bool readRecord(StreamBuffer & sb, uint32_t length, uint8_t value)
+{
+	std::vector<uint8_t> data(8192);
+	if (sb.readRecord(data.size(), data.data()) != length) { return false; }
+	for (uint32_t i = 0; i < length; ++i)
+	{
+		if (data[i] != value)
+			return false;
+	}
+	return true;
+}
+
+// Records are read back whole, never torn across the end of the buffer.
+
+void test_records(std::string const & title, uint32_t capacity)
+{
+	StreamBuffer sb;
+	assert(sb.init(capacity));
+	
+	uint32_t record = capacity / 3;
+	uint8_t written = 0;
+	uint8_t read = 0;
+	for (int i = 0; i < 20; ++i)
+	{
+		assert(writeRecord(sb, record - i, written) == record - i);
+		written++;
+		BufferSpan span;
+		assert(sb.peekRecord(span) == record - i);
+		assert(span.length == record - i && span.data[0] == read && span.data[span.length - 1] == read);
+		assert(readRecord(sb, record - i, read));
+		read++;
+	}
+	
+	// The reader sees nothing until a whole record is committed.
+	BufferSpan span, view;
+	assert(sb.peekRecord(view) == 0);
+	assert(sb.reserveRecord(100, span));
+	assert(sb.peekRecord(view) == 0);
+	span.length = 50;			// Shrink before committing.
+	assert(sb.commitRecordWrite(span) == 50);
+	assert(sb.peekRecord(view) == 50 && view.data == span.data);
+	assert(sb.commitRecord() == 50);
+	assert(sb.commitRecord() == 0);
+	
+	std::cout << title << ": OK\n";
+}
+
+
+int main()
+{
+	// An odd capacity exercises the padding markers, a page-sized one the mirrored mapping.
+	test_records("Padded records", 1001);
+	test_records("Mirrored records", 4096);
+	
+	// A writer fails right away when the record does not fit.
+	StreamBuffer sb;
+	assert(sb.init(1000));
+	assert(writeRecord(sb, 600, 1) == 600);
+	assert(writeRecord(sb, 600, 2) == 0);
+	assert(writeRecord(sb, 1000, 2) == 0);		// Never fits.
+	uint8_t small[10];
+	assert(sb.readRecord(sizeof(small), small) == 0);		// Does not fit the reader's buffer.
+	assert(readRecord(sb, 600, 1));
+	std::cout << "Fail when full: OK\n";
+	
+	// Or waits for the reader to make room.
+	sb.setRecordFull(DB_FULL_BLOCK, 5000);
+	assert(writeRecord(sb, 600, 1) == 600);
+	std::thread reader([&sb] {
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		assert(readRecord(sb, 600, 1));
+	});
+	assert(writeRecord(sb, 600, 2) == 600);
+	reader.join();
+	assert(readRecord(sb, 600, 2));
+	
+	sb.setRecordFull(DB_FULL_BLOCK, 10);
+	assert(writeRecord(sb, 600, 3) == 600);
+	assert(writeRecord(sb, 600, 4) == 0);		// Times out.
+	std::cout << "Block when full: OK\n";
+	
+	// A corrupt length prefix is not taken as a record, even if adding the prefix size to it 
+	// wraps around.
+	StreamBuffer cb;
+	assert(cb.init(4096));
+	uint32_t corrupt = UINT32_MAX - 2;
+	char frame[8] = { 0 };
+	memcpy(frame, &corrupt, sizeof(corrupt));
+	assert(cb.write(frame, sizeof(frame)) == sizeof(frame));
+	BufferSpan record;
+	assert(cb.peekRecord(record) == 0);
+	std::cout << "Corrupt length: OK\n";
+	
+	std::cout << "Done.\n";
+	return 0;
+}
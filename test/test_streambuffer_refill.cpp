@@ -0,0 +1,91 @@
+/*
+	test_streambuffer_refill.cpp - Tests for the StreamBuffer request size & watermarks.
+	
+*/
+
+
+#include "../src/streambuffer.h"
+
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+std::condition_variable dataRequestCv;
+
+
+// Write the requested amount of data, as a data request handler would.
+
+uint32_t serve(StreamBuffer & sb)
+{
+	std::vector<char> data(sb.getDataRequestSize());
+	return sb.write(data.data(), data.size());
+}
+
+
+int main()
+{
+	// Default policy: a full 200 kB block is requested once there is space for it.
+	{
+		StreamBuffer sb;
+		assert(sb.init(512 * 1024));
+		sb.setDataRequestCondition(&dataRequestCv);
+		assert(sb.start());
+		assert(sb.dataRequestPending);
+		assert(sb.getDataRequestSize() == 200 * 1024);
+		assert(serve(sb) == 200 * 1024);
+		assert(sb.dataRequestPending);					// Space for another block.
+		assert(serve(sb) == 200 * 1024);
+		assert(!sb.dataRequestPending);					// Only 112 kB left.
+		std::cout << "Default policy: OK\n";
+	}
+	
+	// Small requests for low-bitrate streams, with watermarks.
+	{
+		StreamBuffer sb;
+		assert(sb.init(64 * 1024));
+		sb.setDataRequestCondition(&dataRequestCv);
+		sb.setRequestSize(4096);
+		sb.setWatermarks(8192, 16384);
+		assert(sb.start());
+		assert(sb.getDataRequestSize() == 4096);
+		
+		// Requests are chained until the high watermark is reached.
+		uint32_t requests = 0;
+		while (sb.dataRequestPending) {
+			assert(serve(sb) == 4096);
+			requests++;
+		}
+		
+		std::cout << "Requests until high watermark: " << requests << "\n";
+		assert(requests == 4);
+		
+		// Reading down to just above the low watermark does not start a request.
+		std::vector<uint8_t> bytes(16384);
+		assert(sb.read(8191, bytes.data()) == 8191);
+		assert(!sb.dataRequestPending);
+		
+		// Reaching the low watermark does.
+		assert(sb.read(1, bytes.data()) == 1);
+		assert(sb.dataRequestPending);
+		assert(sb.getDataRequestSize() == 4096);
+		std::cout << "Watermarks: OK\n";
+	}
+	
+	// Request size larger than the buffer is limited to the free space.
+	{
+		StreamBuffer sb;
+		assert(sb.init(4096));
+		sb.setDataRequestCondition(&dataRequestCv);
+		sb.setRequestSize(1024 * 1024);
+		assert(sb.start());
+		assert(sb.getDataRequestSize() == 4096);
+		assert(serve(sb) == 4096);
+		assert(!sb.dataRequestPending);
+		std::cout << "Oversized request: OK\n";
+	}
+	
+	std::cout << "Done.\n";
+	return 0;
+}
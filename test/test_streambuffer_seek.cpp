@@ -0,0 +1,151 @@
+/*
+	test_streambuffer_seek.cpp - Tests for asynchronous StreamBuffer seeks.
+	
+*/
+
+
+#include "../src/streambuffer.h"
+#include "testpattern.h"
+
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+StreamBuffer sb;
+std::condition_variable dataRequestCv;
+std::vector<int64_t> seekRequests;
+
+
+// Seek handler, only records the request. The test writes the data afterwards.
+
+void seekingHandler(uint32_t, int64_t offset)
+{
+	seekRequests.push_back(offset);
+}
+
+// Write the test pattern for the current generation.
+
+uint32_t writeCurrent(int64_t offset, uint32_t length)
+{
+	return writePattern(sb, offset, length, sb.getGeneration());
+}
+
+bool ready(std::shared_future<int64_t> const & f)
+{
+	return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+
+int main()
+{
+	assert(sb.init(64 * 1024));
+	sb.setFileSize(1024 * 1024);
+	sb.setSeekRequestCallback(seekingHandler);
+	assert(writeCurrent(0, 4096) == 4096);
+	
+	// The seek returns right away, and completes with the first data at the new offset.
+	std::shared_future<int64_t> first = sb.seekAsync(DB_SEEK_START, 100000);
+	assert(!ready(first));
+	assert(sb.seeking());
+	assert(seekRequests.size() == 1 && seekRequests[0] == 100000);
+	uint8_t byte;
+	assert(sb.read(1, &byte) == 0);		// No data while seeking.
+	assert(writeCurrent(100000, 4096) == 4096);
+	assert(ready(first) && first.get() == 100000);
+	assert(!sb.seeking());
+	assert(sb.tell() == 100000);
+	assert(readPattern(sb, 100000, 1024));
+	std::cout << "Async seek: OK\n";
+	
+	// A newer seek cancels the pending one, without waiting for its data. The late data for 
+	// the old seek is discarded.
+	std::shared_future<int64_t> second = sb.seekAsync(DB_SEEK_START, 200000);
+	uint32_t secondGeneration = sb.getGeneration();
+	std::shared_future<int64_t> third = sb.seekAsync(DB_SEEK_START, 300000);
+	assert(ready(second) && second.get() == -1);
+	assert(!ready(third));
+	assert(seekRequests.size() == 3 && seekRequests[2] == 300000);
+	assert(sb.getGeneration() != secondGeneration);
+	assert(writePattern(sb, 200000, 4096, secondGeneration) == 0);		// Late data, discarded.
+	assert(!ready(third));
+	assert(writeCurrent(300000, 4096) == 4096);
+	assert(ready(third) && third.get() == 300000);
+	assert(readPattern(sb, 300000, 4096));
+	std::cout << "Cancelled seek: OK\n";
+	
+	// A seek during a data request does not wait for it, the data for it is discarded.
+	sb.setDataRequestCondition(&dataRequestCv);
+	assert(sb.start());
+	uint32_t requestGeneration = sb.getDataRequestGeneration();
+	std::shared_future<int64_t> fourth = sb.seekAsync(DB_SEEK_CURRENT, 100000);
+	assert(!ready(fourth));
+	assert(seekRequests.size() == 4 && seekRequests[3] == 404096);
+	assert(writePattern(sb, 304096, 4096, requestGeneration) == 0);
+	assert(!ready(fourth));
+	assert(writeCurrent(404096, 4096) == 4096);
+	assert(ready(fourth) && fourth.get() == 404096);
+	assert(readPattern(sb, 404096, 4096));
+	std::cout << "Seek during data request: OK\n";
+	
+	// Stale data does not hold up the new generation, even with the buffer full of unread 
+	// data. The reader skips over the old data.
+	assert(writeCurrent(408192, 60 * 1024) == 60 * 1024);
+	requestGeneration = sb.getGeneration();
+	std::shared_future<int64_t> reload = sb.seekAsync(DB_SEEK_START, 600000);
+	assert(writePattern(sb, 408192 + 60 * 1024, 4096, requestGeneration) == 0);
+	assert(writeCurrent(600000, 32 * 1024) == 32 * 1024);
+	assert(ready(reload) && reload.get() == 600000);
+	assert(readPattern(sb, 600000, 32 * 1024));
+	assert(sb.read(1, &byte) == 0);
+	std::cout << "Generation rebase: OK\n";
+	
+	// An untagged writer can't mark the data of a request as old, so a seek during its request
+	// is requested once that data lands. The late data is discarded.
+	StreamBuffer plain;
+	assert(plain.init(64 * 1024));
+	plain.setFileSize(1024 * 1024);
+	plain.setSeekRequestCallback(seekingHandler);
+	plain.setDataRequestCondition(&dataRequestCv);
+	std::string old(1000, 'A');
+	std::vector<uint8_t> data(1000);
+	assert(plain.write(old) == 1000);
+	assert(plain.read(1000, data.data()) == 1000);		// Requests more data.
+	size_t requests = seekRequests.size();
+	std::shared_future<int64_t> deferred = plain.seekAsync(DB_SEEK_START, 500000);
+	assert(!ready(deferred) && plain.seeking());
+	assert(seekRequests.size() == requests);
+	std::string late(100, 'O');
+	assert(plain.write(late) == 0);
+	assert(!ready(deferred));
+	assert(seekRequests.size() == requests + 1 && seekRequests.back() == 500000);
+	assert(writePattern(plain, 500000, 4096) == 4096);
+	assert(ready(deferred) && deferred.get() == 500000);
+	assert(readPattern(plain, 500000, 4096));
+	std::cout << "Untagged writer: OK\n";
+	
+	// If the writer never answers, the deferred seek times out without being requested. The 
+	// buffer moves to where the writer's data continues, instead of taking it for data at the 
+	// seek target.
+	assert(writePattern(plain, 504096, 2048) == 2048);
+	assert(readPattern(plain, 504096, 2048));		// Requests more data.
+	requests = seekRequests.size();
+	assert(plain.seek(DB_SEEK_START, 800000) == -1);
+	assert(seekRequests.size() == requests && !plain.seeking());
+	assert(plain.tell() == 506144);
+	assert(writePattern(plain, 506144, 4096) == 4096);
+	assert(readPattern(plain, 506144, 4096));
+	std::cout << "Timed out deferred seek: OK\n";
+	
+	// Invalid offsets fail right away.
+	std::shared_future<int64_t> fifth = sb.seekAsync(DB_SEEK_START, 2 * 1024 * 1024);
+	assert(ready(fifth) && fifth.get() == -1);
+	
+	// Synchronous seeks time out if the client does not respond.
+	assert(sb.seek(DB_SEEK_START, 500000) == -1);
+	assert(!sb.seeking());
+	
+	std::cout << "Done.\n";
+	return 0;
+}
@@ -0,0 +1,83 @@
+/*
+	test_streambuffer_sessions.cpp - Several StreamBuffer instances in one process.
+	
+*/
+
+
+#include "../src/databuffer.h"
+
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+std::vector<StreamBuffer*> buffers;
+
+
+// --- SEEKING HANDLER ---
+// Routes the seek request to the buffer of the requesting session.
+uint32_t lastSeekSession = 0;
+
+void seekingHandler(uint32_t session, int64_t) {
+	lastSeekSession = session;
+	std::string data(4, (char) ('A' + (session - 100)));
+	buffers[session - 100]->write(data);
+}
+
+
+int main() {
+	const int sessions = 4;
+	for (int i = 0; i < sessions; ++i) {
+		StreamBuffer* sb = new StreamBuffer;
+		assert(sb->init(16 + i));
+		sb->setSessionHandle(100 + i);
+		sb->setSeekRequestCallback(seekingHandler);
+		sb->setFileSize(1024);
+		buffers.push_back(sb);
+	}
+	
+	// Fill each buffer with its own pattern.
+	for (int i = 0; i < sessions; ++i) {
+		std::string data(10, (char) ('a' + i));
+		assert(buffers[i]->write(data) == 10);
+	}
+	
+	// The default instance stays independent of the others.
+	assert(DataBuffer::init(8));
+	std::string other("zzzz");
+	assert(DataBuffer::write(other) == 4);
+	
+	// Each buffer returns only what was written into it.
+	for (int i = 0; i < sessions; ++i) {
+		uint8_t bytes[16];
+		uint32_t read = buffers[i]->read(16, bytes);
+		std::cout << "Session " << buffers[i]->getSessionHandle() << ": read " << read << " bytes." << std::endl;
+		assert(read == 10);
+		for (uint32_t j = 0; j < read; ++j) {
+			assert(bytes[j] == 'a' + i);
+		}
+	}
+	
+	uint8_t bytes[8];
+	assert(DataBuffer::read(8, bytes) == 4);
+	assert(bytes[0] == 'z');
+	
+	// Seek requests carry the session handle of the buffer they came from.
+	buffers[2]->setEof(true);
+	assert(buffers[2]->seek(DB_SEEK_START, 0) == 0);
+	std::cout << "Seek request from session " << lastSeekSession << std::endl;
+	assert(lastSeekSession == 102);
+	assert(buffers[2]->read(8, bytes) == 4);
+	assert(bytes[0] == 'C');
+	
+	for (int i = 0; i < sessions; ++i) {
+		delete buffers[i];
+	}
+	
+	DataBuffer::cleanup();
+	
+	std::cout << "Done." << std::endl;
+	
+	return 0;
+}
@@ -0,0 +1,218 @@
+/*
+	test_streambuffer_spans.cpp - Tests for the zero-copy StreamBuffer API.
+	
+*/
+
+
+#include "../src/streambuffer.h"
+
+#include <cassert>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+
+// Fill data monotonically increasing, starting at `start`, return next value to use.
+
+int fill(std::vector<uint8_t> & data, int start)
+{
+	std::iota(data.begin(), data.end(), start);
+	return start + data.size();
+}
+
+// Return True if the span continues the sequence at `expected`, advancing it.
+
+bool check_span(BufferSpan const & span, uint8_t & expected)
+{
+	for (uint32_t i = 0; i < span.length; ++i)
+	{
+		if (span.data[i] != expected++)
+			return false;
+	}
+	return true;
+}
+
+// Test peek/commit on a buffer that is prefilled, partially consumed and refilled across the wrap.
+
+void test_peek_case(std::string const & title, int capacity, int Nwarmup, int Nread, int Nwrite)
+{
+	std::cout << title << " capacity:" << capacity << " warmup:" << Nwarmup
+				<< " read:" << Nread << " write:" << Nwrite << "\n";
+	
+	StreamBuffer sb;
+	assert(sb.init(capacity));
+	
+	std::vector<uint8_t> Bwarmup(Nwarmup);
+	std::vector<uint8_t> Bwrite(Nwrite);
+	int value = 0;
+	value = fill(Bwarmup, value);
+	value = fill(Bwrite, value);
+	
+	assert(sb.write((const char*) Bwarmup.data(), Nwarmup) == (uint32_t) Nwarmup);
+	
+	BufferSpan first, second;
+	assert(sb.peek(first, second) == (uint32_t) Nwarmup);
+	assert(second.length == 0);
+	assert(sb.commit(Nread) == (uint32_t) Nread);
+	
+	uint32_t Nactual = sb.write((const char*) Bwrite.data(), Nwrite);
+	uint32_t unread = sb.peek(first, second);
+	std::cout << "first: " << first.length << " second: " << second.length << "\n";
+	assert(unread == Nwarmup - Nread + Nactual);
+	assert(first.length + second.length == unread);
+	
+	// Spans must continue the written sequence, without copying.
+	uint8_t expected = Nread;
+	assert(check_span(first, expected));
+	assert(check_span(second, expected));
+	
+	// Committing more than is unread is clamped.
+	assert(sb.commit(unread + 10) == unread);
+	assert(sb.peek(first, second) == 0);
+}
+
+// Test reserve/commitWrite by writing a sequence straight into the ring, across the wrap.
+
+void test_reserve_case(std::string const & title, int capacity, int Nwarmup, int Nread, int Nreserve, int Ncommit)
+{
+	std::cout << title << " capacity:" << capacity << " warmup:" << Nwarmup << " read:" << Nread
+				<< " reserve:" << Nreserve << " commit:" << Ncommit << "\n";
+	
+	StreamBuffer sb;
+	assert(sb.init(capacity));
+	
+	std::vector<uint8_t> Bwarmup(Nwarmup);
+	int value = fill(Bwarmup, 0);
+	assert(sb.write((const char*) Bwarmup.data(), Nwarmup) == (uint32_t) Nwarmup);
+	std::vector<uint8_t> Bread(capacity);
+	assert(sb.read(Nread, Bread.data()) == (uint32_t) Nread);
+	
+	BufferSpan first, second;
+	uint32_t reserved = sb.reserve(Nreserve, first, second);
+	std::cout << "first: " << first.length << " second: " << second.length << "\n";
+	assert(reserved == first.length + second.length);
+	assert(reserved <= (uint32_t) Nreserve);
+	assert(reserved <= (uint32_t) (capacity - Nwarmup + Nread));
+	
+	// Nothing becomes visible to the reader before the commit.
+	BufferSpan rfirst, rsecond;
+	assert(sb.peek(rfirst, rsecond) == (uint32_t) (Nwarmup - Nread));
+	
+	for (uint32_t i = 0; i < first.length; ++i) { first.data[i] = value++; }
+	for (uint32_t i = 0; i < second.length; ++i) { second.data[i] = value++; }
+	uint32_t committed = sb.commitWrite(Ncommit);
+	assert(committed == (uint32_t) Ncommit);
+	
+	uint32_t unread = sb.read(capacity, Bread.data());
+	assert(unread == Nwarmup - Nread + committed);
+	for (uint32_t i = 0; i < unread; ++i) { assert(Bread[i] == Nread + i); }
+}
+
+// Test the mirrored mapping: wrapped sections are returned as a single contiguous span.
+
+void test_mirrored_case(std::string const & title, int capacity)
+{
+	std::cout << title << " capacity:" << capacity << "\n";
+	
+	StreamBuffer sb;
+	assert(sb.init(capacity));
+	if (!sb.isMirrored()) {
+		std::cout << "Mirrored mapping not available, skipping.\n";
+		return;
+	}
+	
+	// Move the read and write pointers to near the end of the buffer.
+	std::vector<uint8_t> Bwarmup(capacity - 100);
+	int value = fill(Bwarmup, 0);
+	assert(sb.write((const char*) Bwarmup.data(), Bwarmup.size()) == Bwarmup.size());
+	assert(sb.commit(Bwarmup.size()) == Bwarmup.size());
+	
+	// Reserving across the wrap returns one span.
+	BufferSpan first, second;
+	assert(sb.reserve(300, first, second) == 300);
+	assert(first.length == 300 && second.length == 0);
+	for (uint32_t i = 0; i < first.length; ++i) { first.data[i] = value++; }
+	assert(sb.commitWrite(300) == 300);
+	
+	// The unread section wraps around, but is one span for the reader as well.
+	assert(sb.peek(first, second) == 300);
+	assert(first.length == 300 && second.length == 0);
+	uint8_t expected = capacity - 100;
+	assert(check_span(first, expected));
+	
+	// A plain read across the wrap returns the same data.
+	std::vector<uint8_t> Bread(300);
+	assert(sb.read(300, Bread.data()) == 300);
+	expected = capacity - 100;
+	for (uint32_t i = 0; i < Bread.size(); ++i) { assert(Bread[i] == expected++); }
+}
+
+
+// Test writev/readv: segments of varying size go in and come out across the wrap.
+
+void test_vectored_case(std::string const & title, int capacity)
+{
+	std::cout << title << " capacity:" << capacity << "\n";
+	
+	StreamBuffer sb;
+	assert(sb.init(capacity));
+	sb.setEof(true);	// No data requests.
+	
+	std::vector<uint8_t> Bin(capacity * 3);
+	fill(Bin, 0);
+	std::vector<uint8_t> Bout(Bin.size());
+	uint32_t written = 0;
+	uint32_t read = 0;
+	for (int round = 0; round < 500; ++round)
+	{
+		// Three segments, the last of which may not fit.
+		BufferSpan in[3];
+		uint32_t offset = written;
+		for (int i = 0; i < 3; ++i)
+		{
+			in[i].data = Bin.data() + (offset % Bin.size());
+			in[i].length = (round * 7 + i * 5) % 23 + (i == 1 ? 0 : 1);
+			uint32_t left = Bin.size() - offset % Bin.size();
+			if (in[i].length > left) { in[i].length = left; }
+			offset += in[i].length;
+		}
+		written += sb.writev(in, 3);
+		
+		// Read into segments of a different size.
+		BufferSpan out[2];
+		out[0].data = Bout.data();
+		out[0].length = (round * 3) % 11;
+		out[1].data = Bout.data() + out[0].length;
+		out[1].length = 17;
+		uint32_t n = sb.readv(out, 2);
+		for (uint32_t i = 0; i < n; ++i) { assert(Bout[i] == Bin[(read + i) % Bin.size()]); }
+		read += n;
+		assert(written - read == sb.peek(out[0], out[1]));
+	}
+	
+	assert(written > (uint32_t) capacity && read > (uint32_t) capacity);
+	
+	// Segments that don't fit are written partially.
+	BufferSpan first, second;
+	sb.commit(sb.peek(first, second));
+	BufferSpan big[2] = { { Bin.data(), (uint32_t) capacity - 2 }, { Bin.data(), 5 } };
+	assert(sb.writev(big, 2) == (uint32_t) capacity);
+	assert(sb.writev(big, 2) == 0);
+}
+
+int main()
+{
+	test_peek_case("Test 1:", 7, 3, 0, 3);		// No wrap.
+	test_peek_case("Test 2:", 7, 5, 3, 5);		// Unread section wraps around.
+	test_peek_case("Test 3:", 7, 7, 7, 7);		// Read pointer wrapped to the front.
+	test_reserve_case("Test 4:", 7, 3, 0, 3, 3);	// Reserve at back.
+	test_reserve_case("Test 5:", 7, 5, 3, 5, 5);	// Reserve wraps around.
+	test_reserve_case("Test 6:", 7, 5, 3, 9, 4);	// Reserve limited by free space, partial commit.
+	test_mirrored_case("Test 7:", 64 * 1024);		// Mirrored mapping.
+	test_vectored_case("Test 8:", 31);				// Vectored, wrapping.
+	test_vectored_case("Test 9:", 4096);			// Vectored, mirrored.
+	
+	std::cout << "Done.\n";
+	return 0;
+}
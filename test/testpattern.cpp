@@ -0,0 +1,38 @@
+/*
+	testpattern.cpp - Test pattern shared by the buffer tests.
+	
+	Revision 0
+	
+	Notes:
+			- 
+		
+	2026/10/17
+*/
+
+
+#include "testpattern.h"
+
+
+// --- PATTERN BYTE ---
+// Returns the pattern byte at stream position 'offset'.
+uint8_t patternByte(int64_t offset) {
+	return (uint8_t) (offset % 251);
+}
+
+
+// --- FILL PATTERN ---
+// Fill 'length' bytes with the pattern, starting at stream position 'offset'.
+void fillPattern(uint8_t* data, uint32_t length, int64_t offset) {
+	for (uint32_t i = 0; i < length; ++i) { data[i] = patternByte(offset + i); }
+}
+
+
+// --- CHECK PATTERN ---
+// Returns true if 'length' bytes match the pattern at stream position 'offset'.
+bool checkPattern(const uint8_t* data, uint32_t length, int64_t offset) {
+	for (uint32_t i = 0; i < length; ++i) {
+		if (data[i] != patternByte(offset + i)) { return false; }
+	}
+	
+	return true;
+}
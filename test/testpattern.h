@@ -0,0 +1,61 @@
+/*
+	testpattern.h - Test pattern shared by the buffer tests.
+	
+	Revision 0
+	
+	Notes:
+			- Each byte is derived from its position in the stream, so that data read back 
+				after wraps, seeks and out-of-order writes can be checked on its own.
+			- The buffer helpers are templates, so that tests only link the buffer they use.
+		
+	2026/10/17
+*/
+
+
+#ifndef TESTPATTERN_H
+#define TESTPATTERN_H
+
+
+#include <cstdint>
+#include <vector>
+
+
+uint8_t patternByte(int64_t offset);
+void fillPattern(uint8_t* data, uint32_t length, int64_t offset);
+bool checkPattern(const uint8_t* data, uint32_t length, int64_t offset);
+
+
+// --- WRITE PATTERN ---
+// Write 'length' bytes of the pattern into a buffer, starting at stream position 'offset'.
+// Returns the number of bytes written.
+template <typename Buffer>
+uint32_t writePattern(Buffer &sb, int64_t offset, uint32_t length) {
+	std::vector<uint8_t> data(length);
+	fillPattern(data.data(), length, offset);
+	return sb.write((const char*) data.data(), length);
+}
+
+
+// Like writePattern(), for data obtained for the given generation.
+template <typename Buffer>
+uint32_t writePattern(Buffer &sb, int64_t offset, uint32_t length, uint32_t generation) {
+	std::vector<uint8_t> data(length);
+	fillPattern(data.data(), length, offset);
+	return sb.write((const char*) data.data(), length, generation);
+}
+
+
+// --- READ PATTERN ---
+// Read 'length' bytes from a buffer and check them against the pattern at stream position 
+// 'offset'.
+// Returns false if fewer bytes were read or they don't match, otherwise true.
+template <typename Buffer>
+bool readPattern(Buffer &sb, int64_t offset, uint32_t length) {
+	std::vector<uint8_t> data(length);
+	if (sb.read(length, data.data()) != length) { return false; }
+	
+	return checkPattern(data.data(), length, offset);
+}
+
+
+#endif